@@ -0,0 +1,224 @@
+// heap.cc
+//     	Routines to manage a priority queue kept as a binary heap.
+//	See heap.h.
+//
+//	The array of items starts small and doubles when it fills up;
+//	it never shrinks, so a heap that is used over and over stops
+//	allocating memory.
+//
+//     	NOTE: Mutual exclusion must be provided by the caller.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+const int InitialHeapSize = 16;	// how many items a new heap has room for
+
+#include "copyright.h"
+
+//----------------------------------------------------------------------
+// Heap<T>::Heap
+//	Initialize an empty heap.
+//
+//	"comp" -- function for ordering the items
+//----------------------------------------------------------------------
+
+template <class T>
+Heap<T>::Heap(int (*comp)(T x, T y))
+{
+    compare = comp;
+    size = InitialHeapSize;
+    items = new T[size];
+    numInHeap = 0;
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::~Heap
+//	Prepare a heap for deallocation.  The items themselves are
+//	the caller's.
+//----------------------------------------------------------------------
+
+template <class T>
+Heap<T>::~Heap()
+{
+    delete [] items;
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::Insert
+//	Put an item into the heap: add it at the end, and move it up
+//	past any larger parents.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::Insert(T item)
+{
+    if (numInHeap == size) {		// full: double the array
+	T *bigger = new T[size * 2];
+
+	for (int i = 0; i < numInHeap; i++)
+	    bigger[i] = items[i];
+	delete [] items;
+	items = bigger;
+	size *= 2;
+    }
+    items[numInHeap] = item;
+    SiftUp(numInHeap++);
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::RemoveFront
+//	Remove the smallest item from the heap, and return it: move the
+//	last item into its place, and down past any smaller children.
+//----------------------------------------------------------------------
+
+template <class T>
+T
+Heap<T>::RemoveFront()
+{
+    T front;
+
+    ASSERT(numInHeap > 0);
+    front = items[0];
+    items[0] = items[--numInHeap];
+    if (numInHeap > 0)
+	SiftDown(0);
+    return front;
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::Remove
+//	Remove "item" from the heap, wherever it is.  This takes O(n)
+//	time to find the item.  Returns FALSE if it isn't in the heap.
+//----------------------------------------------------------------------
+
+template <class T>
+bool
+Heap<T>::Remove(T item)
+{
+    for (int i = 0; i < numInHeap; i++) {
+	if (items[i] == item) {
+	    items[i] = items[--numInHeap];
+	    if (i < numInHeap) {	// the moved item may belong
+		SiftUp(i);		// above or below i
+		SiftDown(i);
+	    }
+	    return TRUE;
+	}
+    }
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::SiftUp
+//	Move item i up, swapping it with its parent, until its parent
+//	is no larger.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::SiftUp(int i)
+{
+    T item = items[i];
+
+    while (i > 0 && compare(item, items[(i - 1) / 2]) < 0) {
+	items[i] = items[(i - 1) / 2];
+	i = (i - 1) / 2;
+    }
+    items[i] = item;
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::SiftDown
+//	Move item i down, swapping it with its smaller child, until no
+//	child is smaller.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::SiftDown(int i)
+{
+    T item = items[i];
+    int child;
+
+    while ((child = 2 * i + 1) < numInHeap) {
+	if (child + 1 < numInHeap && compare(items[child + 1], items[child]) < 0)
+	    child++;			// the smaller child
+	if (compare(items[child], item) >= 0)
+	    break;
+	items[i] = items[child];
+	i = child;
+    }
+    items[i] = item;
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::Apply
+//	Apply function to every item in the heap, in array order.
+//
+//	"func" -- the function to apply
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::Apply(void (*func)(T)) const
+{
+    for (int i = 0; i < numInHeap; i++)
+	(*func)(items[i]);
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::SanityCheck
+//      Test whether this is still a legal heap.
+//
+//	Test: is every item no smaller than its parent?
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::SanityCheck() const
+{
+    ASSERT(numInHeap >= 0 && numInHeap <= size);
+    for (int i = 1; i < numInHeap; i++)
+	ASSERT(compare(items[(i - 1) / 2], items[i]) <= 0);
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::SelfTest
+//      Test whether this module is working.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::SelfTest(T *p, int numEntries)
+{
+    int i, round;
+    T *q = new T[numEntries];
+
+    ASSERT(IsEmpty());
+    for (round = 0; round < 2; round++) {   // 2nd time, no allocation
+	for (i = 0; i < numEntries; i++) {
+	    Insert(p[i]);
+	    ASSERT(NumInHeap() == i + 1);
+	}
+	SanityCheck();
+
+	// removing an item from the middle keeps it a heap
+	ASSERT(Remove(p[numEntries / 2]));
+	ASSERT(NumInHeap() == numEntries - 1);
+	SanityCheck();
+	Insert(p[numEntries / 2]);
+
+	// should be able to get out everything we put in, in order
+	for (i = 0; i < numEntries; i++) {
+	    q[i] = RemoveFront();
+	    SanityCheck();
+	}
+	ASSERT(IsEmpty());
+	for (i = 0; i < (numEntries - 1); i++) {
+	    ASSERT(compare(q[i], q[i + 1]) <= 0);
+	}
+    }
+    delete [] q;
+}
@@ -0,0 +1,68 @@
+// heap.h
+//	Data structures to manage a priority queue, as a binary heap:
+//	items can be put in in any order, and are taken out smallest
+//	first, according to a comparison function supplied by the caller.
+//
+//	Unlike a SortedList, inserting and removing take O(log n) time,
+//	and no memory is allocated once the heap has grown to its
+//	largest size.  Items that compare equal come out in no particular
+//	order; the caller must break ties in the comparison if it cares.
+//
+//	Allocation and deallocation of the items in the heap are to
+//	be done by the caller.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef HEAP_H
+#define HEAP_H
+
+#include "copyright.h"
+#include "debug.h"
+
+// The following class defines a binary min-heap of items of type T,
+// kept in an array: the children of item i are items 2i+1 and 2i+2,
+// and no item is smaller than its parent.
+
+template <class T>
+class Heap {
+  public:
+    Heap(int (*comp)(T x, T y));	// initialize an empty heap; comp(x,y)
+					// returns -1 if x belongs before y,
+					// 0 if they are equal, 1 otherwise
+    ~Heap();			// de-allocate the heap (not its items)
+
+    void Insert(T item);	// put an item into the heap
+    T RemoveFront();		// remove the smallest item, and return it
+    T Front() const { ASSERT(numInHeap > 0); return items[0]; }
+				// return the smallest item, without
+				// removing it
+    bool Remove(T item);	// remove an item from anywhere in the
+				// heap; FALSE if it isn't there
+
+    bool IsEmpty() const { return numInHeap == 0; }
+    int NumInHeap() const { return numInHeap; }
+
+    void Apply(void (*f)(T)) const;
+				// apply function to all items in the
+				// heap, in no particular order
+
+    void SanityCheck() const;	// is this still a legal heap?
+    void SelfTest(T *p, int numEntries);
+				// verify module is working
+
+  private:
+    int (*compare)(T x, T y);	// function for ordering items
+    T *items;			// the heap, in items[0..numInHeap-1]
+    int numInHeap;		// number of items in the heap
+    int size;			// number of items there is room for
+
+    void SiftUp(int i);		// restore the heap property, after
+    void SiftDown(int i);	// item i became smaller or larger
+};
+
+#include "heap.cc"		// templates are really like macros
+				// so needs to be included in every
+				// file that uses the template
+#endif // HEAP_H
@@ -1,8 +1,6 @@
 // alarm.cc
 //	Routines to use a hardware timer device to provide a
-//	software alarm clock.  For now, we just provide time-slicing.
-//
-//	Not completely implemented.
+//	software alarm clock: time-slicing, and sleeping threads.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -12,34 +10,83 @@
 #include "alarm.h"
 #include "main.h"
 
+// Compare sleeping threads by when they wake up; threads due at the
+// same time wake in the order they went to sleep.
+static int
+WakeCompare(Thread *a, Thread *b)
+{
+    if (a->getWakeTime() != b->getWakeTime())
+	return (a->getWakeTime() < b->getWakeTime()) ? -1 : 1;
+    if ((int) (a->getWakeOrder() - b->getWakeOrder()) < 0)
+	return -1;
+    return (a->getWakeOrder() != b->getWakeOrder()) ? 1 : 0;
+}
 
-bool Bedroom::IsEmpty() {
-    return _beds.size() == 0;
+//----------------------------------------------------------------------
+// Bedroom::Bedroom
+//	Initialize an empty bedroom, with no wake-up interrupt scheduled.
+//----------------------------------------------------------------------
+
+Bedroom::Bedroom()
+{
+    _beds = new Heap<Thread *>(WakeCompare);
+    _alarm_at = -1;
+    _next_order = 0;
+    _woken = FALSE;
 }
 
-void Bedroom::PutToBed(Thread*t, int x) {
+//----------------------------------------------------------------------
+// Bedroom::PutToBed
+//	Put a thread to sleep until "x" ticks from now.  If it is to wake
+//	up before any other, schedule an interrupt for then; the one
+//	scheduled before it is left to go off, and do nothing.
+//
+//	"t" is the current thread
+//	"x" is how long it sleeps, at least one tick
+//----------------------------------------------------------------------
+
+void
+Bedroom::PutToBed(Thread *t, int x)
+{
+    int when = kernel->stats->totalTicks + x;
+
     ASSERT(kernel->interrupt->getLevel() == IntOff);
-    _beds.push_back(Bed(t, _current_interrupt + x));
-    t->Sleep(false);
+    ASSERT(t == kernel->currentThread && x > 0);
+    t->setWakeTime(when, _next_order++);
+    _beds->Insert(t);
+    if (_alarm_at < 0 || when < _alarm_at) {
+	_alarm_at = when;
+	kernel->interrupt->Schedule(this, x, TimerInt);
+    }
+    t->Sleep(FALSE);
 }
 
-bool Bedroom::MorningCall() {
-    bool woken = false;
-
-    _current_interrupt ++;
-
-    for(std::list<Bed>::iterator it = _beds.begin(); 
-        it != _beds.end(); ) {
-        if(_current_interrupt >= it->when) {
-            woken = true;
-            cout << "Bedroom::MorningCall Thread woken" << endl;
-            kernel->scheduler->ReadyToRun(it->sleeper);
-            it = _beds.erase(it);
-        } else {
-            it++;
-        }
+//----------------------------------------------------------------------
+// Bedroom::CallBack
+//	Interrupt handler for a wake-up interrupt.  Wake the threads that
+//	are due, which are at the front of the heap, and if this was the
+//	interrupt we were waiting for, schedule one for the next thread
+//	to wake up.  Each sleeping thread is looked at only when it wakes.
+//----------------------------------------------------------------------
+
+void
+Bedroom::CallBack()
+{
+    int now = kernel->stats->totalTicks;
+
+    if (now >= _alarm_at)
+	_alarm_at = -1;
+    while (!_beds->IsEmpty() && _beds->Front()->getWakeTime() <= now) {
+	Thread *t = _beds->RemoveFront();
+
+	DEBUG(dbgThread, "Waking thread " << t->getName() << " at " << now);
+	kernel->scheduler->ReadyToRun(t);
+	_woken = TRUE;
+    }
+    if (_alarm_at < 0 && !_beds->IsEmpty()) {
+	_alarm_at = _beds->Front()->getWakeTime();
+	kernel->interrupt->Schedule(this, _alarm_at - now, TimerInt);
     }
-    return woken;
 }
 
 //----------------------------------------------------------------------
@@ -71,6 +118,9 @@ Alarm::Alarm(bool doRandom)
 //
 //	For now, just provide time-slicing.  Only need to time slice 
 //      if we're currently running something (in other words, not idle).
+//	Once the machine is idle, with no thread asleep or just woken,
+//	turn the timer off.  Sleeping threads are woken by the Bedroom's
+//	own interrupts, not here.
 //----------------------------------------------------------------------
 
 void 
@@ -78,10 +128,10 @@ Alarm::CallBack()
 {
     Interrupt *interrupt = kernel->interrupt;
     MachineStatus status = interrupt->getStatus();
-    
-    bool woken = _bedroom.MorningCall();
-    
 
+    bool woken = _bedroom.AnyWoken();
+
+    _bedroom.ClearWoken();		// for the next timer interrupt
     if(status == IdleMode && !woken && _bedroom.IsEmpty())
     {
 	//if(!interrupt->AnyFutureInterrupts())
@@ -95,13 +145,23 @@ Alarm::CallBack()
     }
 }
 
+//----------------------------------------------------------------------
+// Alarm::WaitUntil
+//	Suspend the current thread for "x" timer intervals, of TimerTicks
+//	each; the Bedroom wakes it once the time is up.
+//
+//	"x" -- how long to sleep; if it is not positive, return at once
+//----------------------------------------------------------------------
+
 void
 Alarm::WaitUntil(int x)
 {
+    IntStatus oldLevel;
 
-    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
-    Thread* t = kernel->currentThread;
-    cout << "Alarm::WaitUntil go sleep" << endl;
-    _bedroom.PutToBed(t, x);
-    kernel->interrupt->SetLevel(oldLevel);
+    if (x <= 0)
+	return;
+    oldLevel = kernel->interrupt->SetLevel(IntOff);
+    DEBUG(dbgThread, "Thread " << kernel->currentThread->getName() << " sleeps for " << x * TimerTicks << " ticks");
+    _bedroom.PutToBed(kernel->currentThread, x * TimerTicks);
+    (void) kernel->interrupt->SetLevel(oldLevel);
 }
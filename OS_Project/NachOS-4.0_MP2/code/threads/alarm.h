@@ -8,8 +8,6 @@
 //	From this, we provide the ability for a thread to be
 //	woken up after a delay; we also provide time-slicing.
 //
-//	NOTE: this abstraction is not completely implemented.
-//
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
 // of liability and disclaimer of warranty provisions.
@@ -21,25 +19,31 @@
 #include "utility.h"
 #include "callback.h"
 #include "timer.h"
-#include <list>
+#include "heap.h"
 #include "thread.h"
-class Bedroom {
+
+// The threads asleep in Alarm::WaitUntil, in a heap by when they are
+// to wake up.  Rather than looking at them on every timer interrupt,
+// we schedule an interrupt of our own for the earliest: it wakes
+// only the threads that are due, and schedules the next.
+class Bedroom : public CallBackObj {
     public:
-        Bedroom():_current_interrupt(0) {};
+        Bedroom();
+        ~Bedroom() { delete _beds; }
         void PutToBed(Thread *t, int x);
-    bool MorningCall();
-    bool IsEmpty();
+				// t sleeps for x ticks
+    bool IsEmpty() { return _beds->IsEmpty(); }
+    bool AnyWoken() { return _woken; }
+				// has it woken a thread since the
+				// last ClearWoken?
+    void ClearWoken() { _woken = FALSE; }
     private:
-        class Bed {
-            public:
-                Bed(Thread* t, int x):
-                    sleeper(t), when(x) {};
-                Thread* sleeper;
-                int when;
-        };
-    
-    int _current_interrupt;
-    std::list<Bed> _beds;
+    Heap<Thread *> *_beds;	// by wake time
+    bool _woken;
+    int _alarm_at;		// when the next wake-up interrupt is
+				// scheduled, or -1 if there is none
+    unsigned int _next_order;	// stamp for the next thread put to bed
+    void CallBack();		// called at a wake-up interrupt
 };
 
 
@@ -50,12 +54,12 @@ class Alarm : public CallBackObj {
 				// to "toCall" every time slice.
     ~Alarm() { delete timer; }
     
-    void WaitUntil(int x);	// suspend execution until time > now + x
-                                // this method is not yet implemented
+    void WaitUntil(int x);	// suspend execution for x timer
+				// intervals (TimerTicks each)
 
   private:
     Timer *timer;		// the hardware timer device
-    Bedroom _bedroom;
+    Bedroom _bedroom;		// the threads in WaitUntil
     void CallBack();		// called when the hardware
 				// timer generates an interrupt
 };
@@ -106,6 +106,9 @@ class Thread {
 	int getID() { return (ID); }
     void Print() { cout << name; }
     void SelfTest();		// test whether thread impl is working
+    void setWakeTime(int t, unsigned int order) { wakeTime = t; wakeOrder = order; }
+    int getWakeTime() { return wakeTime; }
+    unsigned int getWakeOrder() { return wakeOrder; }
 
   private:
     // some of the private data for this class is listed above
@@ -116,6 +119,10 @@ class Thread {
     ThreadStatus status;	// ready, running or blocked
     char* name;
 	int   ID;
+    int wakeTime;		// when to wake it, if it is asleep in
+				// Alarm::WaitUntil
+    unsigned int wakeOrder;	// when it went to sleep, to wake threads
+				// due together in that order
     void StackAllocate(VoidFunctionPtr func, void *arg);
     				// Allocate a stack for thread.
 				// Used internally by Fork()
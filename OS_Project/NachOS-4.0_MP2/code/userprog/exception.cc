@@ -70,6 +70,9 @@ ExceptionHandler(ExceptionType which)
       	case SC_Sleep:
 			val = (int)kernel->machine->ReadRegister(4);
 			cout << "Sleep Time " << val << "(ms) " << endl;
+			kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
+			kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
+			kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);
 			kernel->alarm->WaitUntil(val);
 			return;
 			break;
@@ -1,6 +1,8 @@
 // libtest.cc 
 //	Driver code to call self-test routines for standard library
-//	classes -- bitmaps, lists, sorted lists, and hash tables.
+//	classes -- bitmaps, lists, sorted lists, heaps, and hash tables --
+//	and to time the sorted list against the heap as a queue of
+//	pending interrupts.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -11,6 +13,7 @@
 #include "bitmap.h"
 #include "list.h"
 #include "hash.h"
+#include "heap.h"
 #include "sysdep.h"
 
 //----------------------------------------------------------------------
@@ -53,6 +56,10 @@ HashKey(char *str) {
 // Array of values to be inserted into a List or SortedList. 
 static int listTestVector[] = { 9, 5, 7 };
 
+// Array of values to be inserted into a Heap; enough to make it grow.
+static int heapTestVector[] = { 31, 4, 15, 9, 26, 5, 35, 8, 97, 93, 23,
+			84, 62, 64, 33, 83, 27, 95, 2, 88, 41, 97, 16 };
+
 // Array of values to be inserted into the HashTable
 // There are enough here to force a ReHash().
 static char *hashTestVector[] = { "0", "1", "2", "3", "4", "5", "6",
@@ -60,7 +67,7 @@ static char *hashTestVector[] = { "0", "1", "2", "3", "4", "5", "6",
 
 //----------------------------------------------------------------------
 // LibSelfTest
-//	Run self tests on bitmaps, lists, sorted lists, and 
+//	Run self tests on bitmaps, lists, sorted lists, heaps, and 
 //	hash tables.
 //----------------------------------------------------------------------
 
@@ -69,6 +76,7 @@ LibSelfTest () {
     Bitmap *map = new Bitmap(200);
     List<int> *list = new List<int>;
     SortedList<int> *sortList = new SortedList<int>(IntCompare);
+    Heap<int> *heap = new Heap<int>(IntCompare);
     HashTable<int, char *> *hashTable = 
 	new HashTable<int, char *>(HashKey, HashInt);
 	
@@ -76,10 +84,164 @@ LibSelfTest () {
     map->SelfTest();
     list->SelfTest(listTestVector, sizeof(listTestVector)/sizeof(int));
     sortList->SelfTest(listTestVector, sizeof(listTestVector)/sizeof(int));
+    heap->SelfTest(heapTestVector, sizeof(heapTestVector)/sizeof(int));
     hashTable->SelfTest(hashTestVector, sizeof(hashTestVector)/sizeof(char *));
 
     delete map;
     delete list;
     delete sortList;
+    delete heap;
     delete hashTable;
 }
+
+// A pending interrupt, as far as the interrupt queue is concerned.
+class BenchEvent {
+  public:
+    int when;			// when it is due
+    unsigned int order;		// ties are broken by when it was scheduled
+};
+
+//----------------------------------------------------------------------
+// BenchCompare
+//	Compare two pending interrupts the same way Interrupt's
+//	PendingCompare does.
+//----------------------------------------------------------------------
+
+static int
+BenchCompare(BenchEvent *x, BenchEvent *y)
+{
+    if (x->when < y->when) { return -1; }
+    else if (x->when > y->when) { return 1; }
+    else if ((int) (x->order - y->order) < 0) { return -1; }
+    else if (x->order != y->order) { return 1; }
+    else { return 0; }
+}
+
+// How far in the future interrupts are scheduled: every delay from
+// 1 to BenchMaxDelay ticks is equally likely.
+const int BenchMaxDelay = 1000;
+
+//----------------------------------------------------------------------
+// BenchDelay
+//	Return the next delay of a repeatable sequence.  We don't use
+//	RandomNumber, so that timing does not change the random
+//	numbers seen by the rest of Nachos.
+//----------------------------------------------------------------------
+
+static int
+BenchDelay(unsigned int *seed)
+{
+    *seed = *seed * 1103515245 + 12345;
+    return (int) ((*seed >> 16) % BenchMaxDelay) + 1;
+}
+
+//----------------------------------------------------------------------
+// TimeSortedList
+//	Return how long, in seconds, one CheckIfDue plus one Schedule
+//	takes with "numPending" interrupts pending, when they are
+//	kept the way Interrupt used to keep them: a new object for
+//	every interrupt, on a sorted list.
+//
+//	"numPending" -- how many interrupts are always pending
+//	"numOps" -- how many interrupts to fire and schedule again
+//----------------------------------------------------------------------
+
+static double
+TimeSortedList(int numPending, int numOps)
+{
+    SortedList<BenchEvent *> *pending =
+		new SortedList<BenchEvent *>(BenchCompare);
+    unsigned int seed = 1, order = 0;
+    double start;
+    BenchEvent *e;
+    int i;
+
+    for (i = 0; i < numPending; i++) {		// Schedule
+	e = new BenchEvent;
+	e->when = BenchDelay(&seed);
+	e->order = order++;
+	pending->Insert(e);
+    }
+    start = HostTime();
+    for (i = 0; i < numOps; i++) {
+	e = pending->RemoveFront();		// CheckIfDue
+	int now = e->when;
+	delete e;
+	e = new BenchEvent;			// Schedule
+	e->when = now + BenchDelay(&seed);
+	e->order = order++;
+	pending->Insert(e);
+    }
+    start = HostTime() - start;
+    while (!pending->IsEmpty()) {
+	delete pending->RemoveFront();
+    }
+    delete pending;
+    return start / numOps;
+}
+
+//----------------------------------------------------------------------
+// TimeHeap
+//	Return how long, in seconds, one CheckIfDue plus one Schedule
+//	takes with "numPending" interrupts pending, when they are
+//	kept the way Interrupt keeps them now: in a heap, reusing
+//	the objects of interrupts that have fired.
+//
+//	"numPending" -- how many interrupts are always pending
+//	"numOps" -- how many interrupts to fire and schedule again
+//----------------------------------------------------------------------
+
+static double
+TimeHeap(int numPending, int numOps)
+{
+    Heap<BenchEvent *> *pending = new Heap<BenchEvent *>(BenchCompare);
+    unsigned int seed = 1, order = 0;
+    double start;
+    BenchEvent *e;
+    int i;
+
+    for (i = 0; i < numPending; i++) {		// Schedule
+	e = new BenchEvent;
+	e->when = BenchDelay(&seed);
+	e->order = order++;
+	pending->Insert(e);
+    }
+    start = HostTime();
+    for (i = 0; i < numOps; i++) {
+	e = pending->RemoveFront();		// CheckIfDue
+	e->when += BenchDelay(&seed);		// Schedule, reusing it
+	e->order = order++;
+	pending->Insert(e);
+    }
+    start = HostTime() - start;
+    while (!pending->IsEmpty()) {
+	delete pending->RemoveFront();
+    }
+    delete pending;
+    return start / numOps;
+}
+
+//----------------------------------------------------------------------
+// LibBenchmark
+//	Time Interrupt's queue of pending interrupts, kept as a sorted
+//	list and as a heap, with more and more interrupts pending, and
+//	print the time per interrupt (one CheckIfDue plus one Schedule)
+//	in nanoseconds.  The sorted list should grow linearly with the
+//	number pending, the heap only logarithmically.
+//----------------------------------------------------------------------
+
+void
+LibBenchmark()
+{
+    static int numPending[] = { 10, 100, 1000, 10000 };
+
+    cout << "pending\tsorted list (ns)\theap (ns)\n";
+    for (int i = 0; i < (int) (sizeof(numPending)/sizeof(int)); i++) {
+	int n = numPending[i];
+	int numOps = 1000 + 10000000 / n;	// enough to take a while,
+						// even for the heap
+
+	cout << n << "\t" << TimeSortedList(n, numOps) * 1e9
+	     << "\t\t\t" << TimeHeap(n, numOps) * 1e9 << "\n";
+    }
+}
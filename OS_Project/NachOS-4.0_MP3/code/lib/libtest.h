@@ -11,5 +11,6 @@
 #include "copyright.h"
 
 extern void LibSelfTest();
+extern void LibBenchmark();	// time the pending interrupt queue
 
 #endif // LIBTEST_H
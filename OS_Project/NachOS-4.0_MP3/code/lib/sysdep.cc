@@ -132,6 +132,21 @@ Delay(int seconds)
     (void) sleep((unsigned) seconds);
 }
 
+//----------------------------------------------------------------------
+// HostTime
+// 	Return the UNIX wall-clock time in seconds, with microsecond
+//	resolution, for measuring how fast the simulation runs.
+//----------------------------------------------------------------------
+
+double
+HostTime()
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
 //----------------------------------------------------------------------
 // UDelay
 // 	Put the UNIX process running Nachos to sleep for x microseconds,
@@ -254,10 +269,11 @@ DeallocBoundedArray(char *ptr, int size)
 //	in, and return TRUE.
 //
 //	"fd" -- the file descriptor of the file to be polled
+//	"wait" -- if TRUE, block until there are characters to be read
 //----------------------------------------------------------------------
 
 bool
-PollFile(int fd)
+PollFile(int fd, bool wait)
 {
 #if defined(SOLARIS) || defined(LINUX)
 // KMS
@@ -282,12 +298,12 @@ PollFile(int fd)
 
 // poll file or socket
 #if defined(BSD)
-    retVal = select(32, (fd_set*)&rfd, (fd_set*)&wfd, (fd_set*)&xfd, &pollTime);
+    retVal = select(32, (fd_set*)&rfd, (fd_set*)&wfd, (fd_set*)&xfd, wait ? NULL : &pollTime);
 #elif defined(SOLARIS) || defined(LINUX)
     // KMS
-    retVal = select(32, &rfd, &wfd, &xfd, &pollTime);
+    retVal = select(32, &rfd, &wfd, &xfd, wait ? NULL : &pollTime);
 #else
-    retVal = select(32, &rfd, &wfd, &xfd, &pollTime);
+    retVal = select(32, &rfd, &wfd, &xfd, wait ? NULL : &pollTime);
 #endif
 
     ASSERT((retVal == 0) || (retVal == 1));
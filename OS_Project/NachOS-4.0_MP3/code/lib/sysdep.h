@@ -24,6 +24,7 @@ extern void Abort();
 extern void Exit(int exitCode);
 extern void Delay(int seconds);
 extern void UDelay(unsigned int usec);// rcgood - to avoid spinners.
+extern double HostTime();		// host wall-clock time, in seconds
 
 // Initialize system so that cleanUp routine is called when user hits ctl-C
 extern void CallOnUserAbort(void (*cleanup)(int));
@@ -38,8 +39,8 @@ extern char *AllocBoundedArray(int size);
 extern void DeallocBoundedArray(char *p, int size);
 
 // Check file to see if there are any characters to be read.
-// If no characters in the file, return without waiting.
-extern bool PollFile(int fd);
+// If no characters in the file, return without waiting (unless "wait").
+extern bool PollFile(int fd, bool wait = FALSE);
 
 // File operations: open/read/write/lseek/close, and check for error
 // For simulating the disk and the console devices.
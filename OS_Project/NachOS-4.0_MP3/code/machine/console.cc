@@ -16,6 +16,10 @@
 #include "console.h"
 #include "main.h"
 #include "stdio.h"
+
+// Longest time between looks for keyboard input, while there is none
+static const int MaxConsolePollTime = 64 * ConsoleTime;
+
 //----------------------------------------------------------------------
 // ConsoleInput::ConsoleInput
 // 	Initialize the simulation of the input for a hardware console device.
@@ -35,6 +39,8 @@ ConsoleInput::ConsoleInput(char *readFile, CallBackObj *toCall)
     // set up the stuff to emulate asynchronous interrupts
     callWhenAvail = toCall;
     incoming = EOF;
+    bufferHead = bufferCount = 0;
+    pollTime = ConsoleTime;
 
     // start polling for incoming keystrokes
     kernel->interrupt->Schedule(this, ConsoleTime, ConsoleReadInt);
@@ -52,44 +58,72 @@ ConsoleInput::~ConsoleInput()
 }
 
 
+//----------------------------------------------------------------------
+// ConsoleInput::FillBuffer()
+// 	Read as many characters as the host has ready, up to a buffer
+//	full.  Return FALSE if there are none yet.  At end of file, the
+//	buffer stays empty, but we return TRUE.
+//
+//	If the machine is idle and nothing else is scheduled, nothing
+//	can happen until a character arrives, so rather than looking
+//	again later, wait for one on the host.
+//----------------------------------------------------------------------
+
+bool
+ConsoleInput::FillBuffer()
+{
+    bool wait = kernel->interrupt->getStatus() == IdleMode
+			&& !kernel->interrupt->AnyFutureInterrupts();
+    int readCount;
+
+    ASSERT(bufferCount == 0);
+    if (!PollFile(readFileNo, wait))
+	return FALSE;
+    readCount = ReadPartial(readFileNo, buffer, ConsoleBufferSize);
+    ASSERT(readCount >= 0);
+    bufferHead = 0;
+    bufferCount = readCount;
+    return TRUE;
+}
+
 //----------------------------------------------------------------------
 // ConsoleInput::CallBack()
 // 	Simulator calls this when a character may be available to be
 //	read in from the simulated keyboard (eg, the user typed something).
 //
-//	First check to make sure character is available.
+//	Characters are read from the host a buffer at a time, and handed
+//	out one per interrupt, ConsoleTime apart.  Only when the buffer
+//	is empty do we look at the host; if it has nothing either, we
+//	look again later, backing off up to MaxConsolePollTime for as
+//	long as nothing is typed.
+//
 //	Then invoke the "callBack" registered by whoever wants the character.
 //----------------------------------------------------------------------
 
 void
 ConsoleInput::CallBack()
 {
-  char c;
-  int readCount;
-
     ASSERT(incoming == EOF);
-    if (!PollFile(readFileNo)) { // nothing to be read
+    if (bufferCount == 0 && !FillBuffer()) { // nothing to be read
         // schedule the next time to poll for a packet
-        kernel->interrupt->Schedule(this, ConsoleTime, ConsoleReadInt);
-    } else { 
-    	// otherwise, try to read a character
-    	readCount = ReadPartial(readFileNo, &c, sizeof(char));
-	if (readCount == 0) {
-	   // this seems to happen at end of file, when the
-	   // console input is a regular file
-	   // don't schedule an interrupt, since there will never
-	   // be any more input
-	   // just do nothing....
-	}
-	else {
-	  // save the character and notify the OS that
-	  // it is available
-	  ASSERT(readCount == sizeof(char));
-	  incoming = c;
-	  kernel->stats->numConsoleCharsRead++;
-	}
-	callWhenAvail->CallBack();
+        kernel->interrupt->Schedule(this, pollTime, ConsoleReadInt);
+	pollTime = min(pollTime * 2, MaxConsolePollTime);
+	return;
     }
+    pollTime = ConsoleTime;
+    if (bufferCount == 0) {
+	// this happens at end of file, when the
+	// console input is a regular file
+	// don't schedule an interrupt, since there will never
+	// be any more input
+    } else {
+	// save the character and notify the OS that
+	// it is available
+	incoming = buffer[bufferHead++];
+	bufferCount--;
+	kernel->stats->numConsoleCharsRead++;
+    }
+    callWhenAvail->CallBack();
 }
 
 //----------------------------------------------------------------------
@@ -129,7 +163,7 @@ ConsoleOutput::ConsoleOutput(char *writeFile, CallBackObj *toCall)
     	writeFileNo = OpenForWrite(writeFile);
 
     callWhenDone = toCall;
-    putBusy = FALSE;
+    numBuffered = numSending = 0;
 }
 
 //----------------------------------------------------------------------
@@ -144,65 +178,73 @@ ConsoleOutput::~ConsoleOutput()
 }
 
 //----------------------------------------------------------------------
-// ConsoleOutput::CallBack()
-// 	Simulator calls this when the next character can be output to the
-//	display.
+// ConsoleOutput::StartSending()
+// 	Send everything in the output buffer to the display, as one
+//	transfer that completes ConsoleTime from now.
 //----------------------------------------------------------------------
 
 void
-ConsoleOutput::CallBack()
+ConsoleOutput::StartSending()
 {
-    putBusy = FALSE;
-    kernel->stats->numConsoleCharsWritten++;
-    callWhenDone->CallBack();
+    ASSERT(numSending == 0 && numBuffered > 0);
+    numSending = numBuffered;
+    kernel->interrupt->Schedule(this, ConsoleTime, ConsoleWriteInt);
 }
 
 //----------------------------------------------------------------------
-// ConsoleOutput::PutChar()
-// 	Write a character to the simulated display, schedule an interrupt 
-//	to occur in the future, and return.
+// ConsoleOutput::CallBack()
+// 	Simulator calls this when the output buffer has been sent to
+//	the display.  Anything written since then goes out next.
 //----------------------------------------------------------------------
 
 void
-ConsoleOutput::PutChar(char ch)
+ConsoleOutput::CallBack()
 {
-    ASSERT(putBusy == FALSE);
-    WriteFile(writeFileNo, &ch, sizeof(char));
-    putBusy = TRUE;
-    kernel->interrupt->Schedule(this, ConsoleTime, ConsoleWriteInt);
+    kernel->stats->numConsoleCharsWritten += numSending;
+    numBuffered -= numSending;
+    numSending = 0;
+    if (numBuffered > 0)
+	StartSending();
+    callWhenDone->CallBack();
 }
 
 //----------------------------------------------------------------------
+// ConsoleOutput::Write()
+// 	Write as many characters of "from" to the simulated display as
+//	there is room for in the output buffer, and return how many.
+//	If the display isn't busy, start sending them.
 //
+//	The characters go to the UNIX file right away, in one write, so
+//	that console output stays in order with everything else Nachos
+//	prints; the buffer only models how long the display takes.
 //
+//	"from" -- the characters to write
+//	"numBytes" -- how many of them
+//----------------------------------------------------------------------
+
+int
+ConsoleOutput::Write(char *from, int numBytes)
+{
+    int n = min(numBytes, ConsoleBufferSize - numBuffered);
+
+    if (n <= 0)
+	return 0;
+    WriteFile(writeFileNo, from, n);
+    numBuffered += n;
+    if (numSending == 0)
+	StartSending();
+    return n;
+}
+
+//----------------------------------------------------------------------
+// ConsoleOutput::PutChar()
+// 	Write a character to the simulated display.
 //----------------------------------------------------------------------
 
 void
-ConsoleOutput::PutInt(int number)
+ConsoleOutput::PutChar(char ch)
 {
-    ASSERT(putBusy == FALSE);
-    int index = 0;
-    bool sign = false;
-    const int buffer_size = 100;
-    char ch[buffer_size] = {'\0'};
-    
-    if(number < 0)
-    {
-        sign = true;
-        number *= -1;
-    }
-    ch[buffer_size-(++index)] = '\n';
-    do{
-        ch[buffer_size-(++index)] = '0' + (number % 10);
-        number /= 10;
-
-    }while(number > 0);
-    if(sign == true)
-    {
-        ch[buffer_size-(++index)] = '-';
-    }
+    int n = Write(&ch, sizeof(char));
 
-    WriteFile(writeFileNo, ch + index + 1, sizeof(char) * (buffer_size - index - 1));
-    putBusy = TRUE;
-    kernel->interrupt->Schedule(this, ConsoleTime, ConsoleWriteInt);
+    ASSERT(n == sizeof(char));
 }
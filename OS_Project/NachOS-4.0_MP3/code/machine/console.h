@@ -11,7 +11,9 @@
 //
 //	In either case, the serial line connecting the computer
 //	to the console has limited bandwidth (like a modem!), and so
-//	each character takes measurable time.
+//	each character takes measurable time.  Output is buffered: the
+//	display takes whatever has been written, up to a buffer full,
+//	as one transfer.
 //
 //	The user of the device registers itself to be called "back" when 
 //	the read/write interrupts occur.  There is a separate interrupt
@@ -31,6 +33,10 @@
 #include "utility.h"
 #include "callback.h"
 
+// How many characters ConsoleInput reads from the host at once, and
+// how many ConsoleOutput can hold on their way to the display
+const int ConsoleBufferSize = 512;
+
 // The following two classes define the input (and output) side of a 
 // hardware console device.  Input (and output) to the device is simulated 
 // by reading (and writing) to the UNIX file "readFile" (and "writeFile").
@@ -65,6 +71,13 @@ class ConsoleInput : public CallBackObj {
     char incoming;    			// Contains the character to be read,
 					// if there is one available. 
 					// Otherwise contains EOF.
+    char buffer[ConsoleBufferSize];	// characters read from the host,
+    int bufferHead;			// but not yet delivered: bufferCount
+    int bufferCount;			// of them, from buffer[bufferHead]
+    int pollTime;			// ticks until we look for input
+					// again, if there is none now
+
+    bool FillBuffer();			// read what the host has, if anything
 };
 
 class ConsoleOutput : public CallBackObj {
@@ -73,18 +86,25 @@ class ConsoleOutput : public CallBackObj {
 				// initialize hardware console output 
     ~ConsoleOutput();		// clean up console emulation
 
-    void PutChar(char ch);	// Write "ch" to the console display, 
-				// and return immediately.  "callWhenDone" 
-				// will called when the I/O completes. 
-    void CallBack();		// Invoked when next character can be put
-				// out to the display.
-    void PutInt(int number);
+    int Write(char *from, int numBytes);
+				// Write as much of "from" as there is
+				// room for to the console display, and
+				// return how much that was.  "callWhenDone"
+				// will be called when a buffer full of
+				// output completes, making more room.
+    void PutChar(char ch);	// Write "ch" to the console display; 
+				// there must be room for it.
+    void CallBack();		// Invoked when the output buffer has
+				// been sent to the display.
   private:
     int writeFileNo;			// UNIX file emulating the display
     CallBackObj *callWhenDone;		// Interrupt handler to call when 
-					// the next char can be put 
-    bool putBusy;    			// Is a PutChar operation in progress?
-					// If so, you can't do another one!
+					// more chars can be put 
+    int numBuffered;			// chars written, but not yet
+					// sent to the display
+    int numSending;			// the first numSending of them
+					// are being sent now
+    void StartSending();		// send everything buffered
 };
 
 #endif // CONSOLE_H
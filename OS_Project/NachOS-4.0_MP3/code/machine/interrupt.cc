@@ -24,6 +24,10 @@
 #include "interrupt.h"
 #include "main.h"
 
+// Longest run of user instructions QuietTicks allows, even when
+// nothing at all is scheduled.
+static const int MaxQuietTicks = 1000;
+
 // String definitions for debugging messages
 
 static char *intLevelNames[] = { "off", "on"};
@@ -47,11 +51,15 @@ PendingInterrupt::PendingInterrupt(CallBackObj *callOnInt,
     callOnInterrupt = callOnInt;
     when = time;
     type = kind;
+    order = 0;
+    next = NULL;
 }
 
 //----------------------------------------------------------------------
 // PendingCompare
 //	Compare to interrupts based on which should occur first.
+//	Interrupts due at the same time occur in the order they were
+//	scheduled.
 //----------------------------------------------------------------------
 
 static int
@@ -59,6 +67,8 @@ PendingCompare (PendingInterrupt *x, PendingInterrupt *y)
 {
     if (x->when < y->when) { return -1; }
     else if (x->when > y->when) { return 1; }
+    else if ((int) (x->order - y->order) < 0) { return -1; }
+    else if (x->order != y->order) { return 1; }
     else { return 0; }
 }
 
@@ -72,7 +82,9 @@ PendingCompare (PendingInterrupt *x, PendingInterrupt *y)
 Interrupt::Interrupt()
 {
     level = IntOff;
-    pending = new SortedList<PendingInterrupt *>(PendingCompare);
+    pending = new Heap<PendingInterrupt *>(PendingCompare);
+    freeInterrupts = NULL;
+    numScheduled = 0;
     inHandler = FALSE;
     yieldOnReturn = FALSE;
     status = SystemMode;
@@ -85,10 +97,17 @@ Interrupt::Interrupt()
 
 Interrupt::~Interrupt()
 {
+    PendingInterrupt *toFree;
+
     while (!pending->IsEmpty()) {
 	delete pending->RemoveFront();
     }
     delete pending;
+    while (freeInterrupts != NULL) {
+	toFree = freeInterrupts;
+	freeInterrupts = toFree->next;
+	delete toFree;
+    }
 }
 
 //----------------------------------------------------------------------
@@ -149,17 +168,15 @@ Interrupt::OneTick()
 {
     MachineStatus oldStatus = status;
     Statistics *stats = kernel->stats;
+    bool switchCPU;
 
 // advance simulated time
     if (status == SystemMode) {
         stats->totalTicks += SystemTick;
 	stats->systemTicks += SystemTick;
+	kernel->scheduler->Charge(kernel->currentThread, SystemTick);
     } else {
-	stats->totalTicks += UserTick;
-	stats->userTicks += UserTick;
-
-	kernel->currentThread->setExecTime(kernel->currentThread->getExecTime() + UserTick);	
-	
+	AdvanceUserTicks(1);
     }
     DEBUG(dbgInt, "== Tick " << stats->totalTicks << " ==");
 
@@ -167,91 +184,12 @@ Interrupt::OneTick()
     ChangeLevel(IntOn, IntOff);	// first, turn off interrupts
 				// (interrupt handlers run with
 				// interrupts disabled)
-    SortedList<Thread *> *queue = kernel->scheduler->getQueue(0);
-    for(ListIterator<Thread *> *it = new ListIterator<Thread *>(queue); !it->IsDone(); it->Next())	
-    {
-	if(stats->totalTicks - it->Item()->getLastCheckInQueueTime() >= 1500)
-	{
-	    kernel->currentThread->setBurstTime(kernel->currentThread->getBurstTime()/2 + kernel->currentThread->getExecTime()/2);
-	    Thread *t = it->Item();
-	    int priority = ((t->getExecPriority()) + 10 < 149 ? (t->getExecPriority() + 10) : 149);
-	    cout << "Tick [" << stats->totalTicks << "]: Thread [" << t->getID() << "] changes its priority from [" << t->getExecPriority() << "] to [" << priority << "]\n";
-	    t->setExecPriority(priority);
-	    t->setLastCheckInQueueTime(stats->totalTicks);
-	    queue->Remove(t);
-	    queue->Insert(t);
-	}
-    }//sort problem
-
-    queue = kernel->scheduler->getQueue(1);
-    for(ListIterator<Thread *> *it = new ListIterator<Thread *>(queue); !it->IsDone(); it->Next())
-    {
-	if(stats->totalTicks - it->Item()->getLastCheckInQueueTime() >= 1500)
-	{
-	    kernel->currentThread->setBurstTime(kernel->currentThread->getBurstTime()/2 + kernel->currentThread->getExecTime()/2);
-	    Thread *t = it->Item();
-	    int priority = t->getExecPriority() + 10;
-	    cout << "Tick [" << stats->totalTicks << "]: Thread [" << t->getID() << "] changes its priority from [" << t->getExecPriority() << "] to [" << priority << "]\n";
-	    t->setExecPriority(priority);
-	    t->setLastCheckInQueueTime(stats->totalTicks);
-	    if(t->getExecPriority() >= 100)
-	    {
-		queue->Remove(it->Item());
-	 	kernel->scheduler->getQueue(0)->Insert(t);
-		cout << "Tick [" << stats->totalTicks << "]: Thread [" << t->getID() << "] is removed from queue L2\n";
-		cout << "Tick [" << stats->totalTicks << "]: Thread [" << t->getID() << "] is inserted into queue L1\n";
-            }
-	    else
-	    {
-		queue->Remove(t);
-		queue->Insert(t);
-	    }
-	}
-    }//sort problem
-				 
-    queue = kernel->scheduler->getQueue(2);
-    for(ListIterator<Thread *> *it = new ListIterator<Thread *>(queue); !it->IsDone(); it->Next())
-    {
-        if(stats->totalTicks - it->Item()->getLastCheckInQueueTime() >= 1500)
-        {
-	    kernel->currentThread->setBurstTime(kernel->currentThread->getBurstTime()/2 + kernel->currentThread->getExecTime()/2);
-            Thread *t = it->Item();
-            int priority = t->getExecPriority() + 10;
-            cout << "Tick [" << stats->totalTicks << "]: Thread [" << t->getID() << "] changes its priority from [" << t->getExecPriority() << "] to [" << priority << "]\n";
-            t->setExecPriority(priority);
-            t->setLastCheckInQueueTime(stats->totalTicks);
-            if(t->getExecPriority() >= 50)
-            {
-                queue->Remove(it->Item());
-                kernel->scheduler->getQueue(1)->Insert(t);
-                cout << "Tick [" << stats->totalTicks << "]: Thread [" << t->getID() << "] is removed from queue L3\n";
-                cout << "Tick [" << stats->totalTicks << "]: Thread [" << t->getID() << "] is inserted into queue L2\n";
-            }
-	    else
-	    {
-		queue->Remove(t);
-                queue->Insert(t);
-	    }
-        }
-    }//sort problem
-    //if(kernel->scheduler->isPreemptive)
-    //{
-    	Thread *nextThread = kernel->scheduler->FindNext();
-    	if(nextThread != NULL && kernel->currentThread->getExecPriority() < 150)
-    	{
-    	    if(nextThread->getExecPriority() > 99)
-	    {
-	    	if(kernel->currentThread->getExecPriority() < 100 || nextThread->getBurstTime() < kernel->currentThread->getBurstTime()){ yieldOnReturn = true;}
-	    }
-   	    else if(nextThread->getExecPriority() > 49)
-	    {
-	   	if(kernel->currentThread->getExecPriority() < 50 || nextThread->getExecPriority() > kernel->currentThread->getExecPriority()) yieldOnReturn = true;
-	    }
-	}
-	//kernel->scheduler->isPreemptive = false;
-    //}
+    kernel->scheduler->Age();	// age threads that have waited
+    if (NeedPreempt())
+	yieldOnReturn = true;
 
     CheckIfDue(FALSE);		// check for pending interrupts
+    switchCPU = kernel->cpus->NeedSwitch();
     ChangeLevel(IntOff, IntOn);	// re-enable interrupts
     if (yieldOnReturn) {	// if the timer device handler asked 
     				// for a context switch, ok to do it now
@@ -259,7 +197,105 @@ Interrupt::OneTick()
  	status = SystemMode;		// yield is a kernel routine
 	kernel->currentThread->Yield();
 	status = oldStatus;
+    } else if (switchCPU) {	// another CPU is too far behind: let
+	status = SystemMode;	// it catch up
+	kernel->cpus->Switch();
+	status = oldStatus;
+    }
+}
+
+//----------------------------------------------------------------------
+// Interrupt::NeedPreempt
+// 	Return TRUE if the thread at the head of the ready queues should
+//	take the CPU away from the current thread.  Called by OneTick
+//	with interrupts disabled.
+//----------------------------------------------------------------------
+
+bool
+Interrupt::NeedPreempt()
+{
+    Thread *nextThread = kernel->scheduler->FindNext();
+
+    if (kernel->scheduler->getSchedulerType() != MultiLevel
+		|| kernel->currentThread->IsRealTime()
+		|| (nextThread != NULL && nextThread->IsRealTime()))
+	return kernel->scheduler->NeedPreempt(kernel->currentThread);
+    if(nextThread != NULL && kernel->currentThread->getExecPriority() < 150)
+    {
+	if(nextThread->getExecPriority() > 99)
+	{
+	    if(kernel->currentThread->getExecPriority() < 100 || nextThread->getBurstTime() < kernel->currentThread->getBurstTime()) return TRUE;
+	}
+	else if(nextThread->getExecPriority() > 49)
+	{
+	    if(kernel->currentThread->getExecPriority() < 50 || nextThread->getExecPriority() > kernel->currentThread->getExecPriority()) return TRUE;
+	}
     }
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::AdvanceUserTicks
+// 	Charge "n" user instructions' worth of time: the part of OneTick
+//	that is done for every user instruction.
+//----------------------------------------------------------------------
+
+void
+Interrupt::AdvanceUserTicks(int n)
+{
+    Statistics *stats = kernel->stats;
+
+    stats->totalTicks += n * UserTick;
+    stats->userTicks += n * UserTick;
+    kernel->currentThread->setExecTime(kernel->currentThread->getExecTime() + n * UserTick);
+    kernel->scheduler->Charge(kernel->currentThread, n * UserTick);
+}
+
+//----------------------------------------------------------------------
+// Interrupt::QuietTicks
+// 	Return how many user instructions can run from now on before
+//	OneTick has anything to do besides advancing the clock: no
+//	pending interrupt falls due, no ready thread is due for aging,
+//	and the current thread is not to be preempted.  No other thread
+//	can become ready until an interrupt, aging, or a trap into the
+//	kernel, but the current thread's own time still counts: a
+//	real-time thread runs out of budget, and under the fair
+//	scheduler, its vruntime gets far enough ahead to be preempted.
+//
+//	The machine may run that many instructions and charge them with
+//	AdvanceUserTicks; the timing of everything else is unchanged.
+//	Returns 0 if tick-by-tick debugging output is enabled.
+//----------------------------------------------------------------------
+
+int
+Interrupt::QuietTicks()
+{
+    Statistics *stats = kernel->stats;
+    int next = stats->totalTicks + MaxQuietTicks;
+    int untilPreempt;
+    bool preempt;
+
+    if (debug->IsEnabled(dbgInt))
+	return 0;
+    ChangeLevel(IntOn, IntOff);
+    preempt = NeedPreempt();
+    untilPreempt = kernel->scheduler->TicksUntilPreempt(kernel->currentThread);
+    ChangeLevel(IntOff, IntOn);
+    if (preempt)
+	return 0;
+
+    if (!pending->IsEmpty())
+	next = min(next, pending->Front()->when);
+    next = min(next, kernel->scheduler->NextAgingTime());
+    if (untilPreempt >= 0)			// fair scheduler: until its
+	next = min(next, stats->totalTicks	// vruntime is too far ahead
+			+ untilPreempt);
+    if (kernel->currentThread->IsRealTime())	// until its budget is gone
+	next = min(next, stats->totalTicks
+			+ kernel->currentThread->getBudgetLeft() + 1);
+    if (kernel->cpus->NumCPUs() > 1)
+	next = min(next, kernel->cpus->NextSwitch());
+    return max(0, (next - stats->totalTicks - 1) / UserTick);
 }
 
 //----------------------------------------------------------------------
@@ -290,14 +326,26 @@ Interrupt::YieldOnReturn()
 //
 //	If there are no pending interrupts, stop.  There's nothing
 //	more for us to do.
+//
+//	The timer is suspended while idle (see Alarm::CallBack), so the
+//	clock jumps straight to the next event that can wake a thread;
+//	once one is ready, the timer is resumed.
+//
+//	With several CPUs, only when none of them has anything to do.
 //----------------------------------------------------------------------
 void
 Interrupt::Idle()
 {
     DEBUG(dbgInt, "Machine idling; checking for interrupts.");
     status = IdleMode;
+    if (kernel->cpus->Idle()) {	// another CPU ran for a while
+	status = SystemMode;
+	return;
+    }
     if (CheckIfDue(TRUE)) {	// check for any pending interrupts
 	status = SystemMode;
+	if (kernel->alarm != NULL && kernel->cpus->AnyReady())
+	    kernel->alarm->Resume();
 	return;			// return in case there's now
 				// a runnable thread
     }
@@ -322,6 +370,8 @@ Interrupt::Halt()
 {
     cout << "Machine halting!\n\n";
     cout << "This is halt\n";
+    if (kernel->cpus->NumCPUs() > 1)
+	kernel->cpus->Report();
     kernel->stats->Print();
     delete kernel;	// Never returns.
 }
@@ -367,7 +417,9 @@ Interrupt::Read(char *buffer, int size, OpenFileId id)
 // 	Arrange for the CPU to be interrupted when simulated time
 //	reaches "now + when".
 //
-//	Implementation: just put it on a sorted list.
+//	Implementation: put it in a heap, ordered by time (O(log n)).
+//	The PendingInterrupt is taken from the interrupts that have
+//	already fired, if there are any, rather than allocated.
 //
 //	NOTE: the Nachos kernel should not call this routine directly.
 //	Instead, it is only called by the hardware device simulators.
@@ -381,11 +433,22 @@ void
 Interrupt::Schedule(CallBackObj *toCall, int fromNow, IntType type)
 {
     int when = kernel->stats->totalTicks + fromNow;
-    PendingInterrupt *toOccur = new PendingInterrupt(toCall, when, type);
+    PendingInterrupt *toOccur;
 
     DEBUG(dbgInt, "Scheduling interrupt handler the " << intTypeNames[type] << " at time = " << when);
     ASSERT(fromNow > 0);
 
+    if (freeInterrupts != NULL) {
+	toOccur = freeInterrupts;
+	freeInterrupts = toOccur->next;
+	toOccur->callOnInterrupt = toCall;
+	toOccur->when = when;
+	toOccur->type = type;
+    } else {
+	toOccur = new PendingInterrupt(toCall, when, type);
+    }
+    toOccur->order = numScheduled++;
+
     pending->Insert(toOccur);
 }
 
@@ -439,7 +502,8 @@ Interrupt::CheckIfDue(bool advanceClock)
     do {
         next = pending->RemoveFront();    // pull interrupt off list
         next->callOnInterrupt->CallBack();// call the interrupt handler
-	delete next;
+	next->next = freeInterrupts;	  // keep it for Schedule
+	freeInterrupts = next;
     } while (!pending->IsEmpty() 
     		&& (pending->Front()->when <= stats->totalTicks));
     inHandler = FALSE;
@@ -35,6 +35,7 @@
 
 #include "copyright.h"
 #include "list.h"
+#include "heap.h"
 #include "callback.h"
 
 // Interrupts can be disabled (IntOff) or enabled (IntOn)
@@ -66,6 +67,9 @@ class PendingInterrupt {
     
     int when;			// When the interrupt is supposed to fire
     IntType type;		// for debugging
+    unsigned int order;		// Schedule calls so far: interrupts due
+				// at the same time fire in this order
+    PendingInterrupt *next;	// next unused interrupt, once it has fired
 };
 
 // The following class defines the data structures for the simulation
@@ -121,12 +125,21 @@ class Interrupt {
     				// by the hardware device simulators.
     
     void OneTick();       	// Advance simulated time
+    int QuietTicks();		// How many user ticks can pass before
+				// OneTick has anything to do
+    void AdvanceUserTicks(int n);
+				// Advance simulated time by "n" user
+				// ticks, without checking for interrupts
 
   private:
     IntStatus level;		// are interrupts enabled or disabled?
-    SortedList<PendingInterrupt *> *pending;		
-    				// the list of interrupts scheduled
-				// to occur in the future
+    Heap<PendingInterrupt *> *pending;		
+    				// the interrupts scheduled to occur
+				// in the future, earliest first
+    PendingInterrupt *freeInterrupts;
+				// interrupts that have fired, to be
+				// reused by Schedule
+    unsigned int numScheduled;	// Schedule calls so far
     //int writeFileNo;            //UNIX file emulating the display
     bool inHandler;		// TRUE if we are running an interrupt handler
     //bool putBusy;               // Is a PrintInt operation in progress
@@ -137,7 +150,9 @@ class Interrupt {
 
     // these functions are internal to the interrupt simulation code
 
-    bool CheckIfDue(bool advanceClock); 
+    bool CheckIfDue(bool advanceClock);
+    bool NeedPreempt();		// Should the current thread yield to
+				// the best ready thread? 
     				// Check if any interrupts are supposed
 				// to occur now, and if so, do them
 
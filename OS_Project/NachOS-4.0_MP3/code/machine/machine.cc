@@ -50,9 +50,11 @@ void CheckEndian()
 //
 //	"debug" -- if TRUE, drop into the debugger after each user instruction
 //		is executed.
+//	"blocks" -- if TRUE, run whole basic blocks between checks for
+//		interrupts, when nothing is due (see Machine::Run)
 //----------------------------------------------------------------------
 
-Machine::Machine(bool debug)
+Machine::Machine(bool debug, bool blocks)
 {
     int i;
 
@@ -61,17 +63,28 @@ Machine::Machine(bool debug)
     mainMemory = new char[MemorySize];
     for (i = 0; i < MemorySize; i++)
       	mainMemory[i] = 0;
-#ifdef USE_TLB
-    tlb = new TranslationEntry[TLBSize];
-    for (i = 0; i < TLBSize; i++)
-	tlb[i].valid = FALSE;
-    pageTable = NULL;
-#else	// use linear page table
+    decodeCache = new Instruction[MemorySize / 4];
+    for (i = 0; i < MemorySize / 4; i++) {	// matches the zeroed memory
+	decodeCache[i].value = 0;
+	decodeCache[i].Decode();
+    }
+    blockLength = new unsigned char[MemorySize / 4];
+    for (i = 0; i < MemorySize / 4; i++)
+	blockLength[i] = 0;
+    InvalidateTranslations();
     tlb = NULL;
-    pageTable = NULL;
+    tlbStamp = NULL;
+#ifdef USE_TLB
+    ConfigureTLB(TLBSize, TLBWays, TLBRandom);
 #endif
+    pageTable = NULL;
+    currentAsid = 0;
+    profile = NULL;
 
     singleStep = debug;
+    useBlocks = blocks;
+    numTraps = 0;
+    uncountedTicks = 0;
     CheckEndian();
 }
 
@@ -83,8 +96,113 @@ Machine::Machine(bool debug)
 Machine::~Machine()
 {
     delete [] mainMemory;
-    if (tlb != NULL)
+    delete [] decodeCache;
+    delete [] blockLength;
+    if (tlb != NULL) {
         delete [] tlb;
+	delete [] tlbStamp;
+    }
+}
+
+//----------------------------------------------------------------------
+// Machine::ConfigureTLB
+// 	Replace the TLB with an empty one of "size" entries, in sets of
+//	"ways" entries (so "ways" == "size" is fully associative, and
+//	"ways" == 1 is direct mapped).
+//
+//	"policy" -- which entry of a full set LoadTLB replaces
+//----------------------------------------------------------------------
+
+void
+Machine::ConfigureTLB(int size, int ways, TLBPolicy policy)
+{
+    ASSERT(size > 0 && ways > 0 && size % ways == 0);
+    if (tlb != NULL) {
+	delete [] tlb;
+	delete [] tlbStamp;
+    }
+    tlb = new TranslationEntry[size];
+    tlbStamp = new unsigned int[size];
+    for (int i = 0; i < size; i++) {
+	tlb[i].valid = FALSE;
+	tlbStamp[i] = 0;
+    }
+    tlbSize = size;
+    tlbWays = ways;
+    tlbPolicy = policy;
+    tlbClock = 0;
+}
+
+//----------------------------------------------------------------------
+// Machine::LoadTLB
+// 	Copy the page table entry "entry" of address space "asid" into
+//	the TLB, replacing an entry of its set if none is free.  The
+//	replaced entry's use and dirty bits are lost; a kernel that
+//	needs them must read them before the entry is replaced.
+//----------------------------------------------------------------------
+
+void
+Machine::LoadTLB(TranslationEntry *entry, int asid)
+{
+    TranslationEntry *set;
+    int first, victim = -1;
+
+    ASSERT(tlb != NULL);
+    first = (entry->virtualPage % (tlbSize / tlbWays)) * tlbWays;
+    set = &tlb[first];
+    for (int i = 0; i < tlbWays && victim < 0; i++)
+	if (!set[i].valid
+		|| (set[i].virtualPage == entry->virtualPage && set[i].asid == asid))
+	    victim = i;
+    if (victim < 0) {
+	if (tlbPolicy == TLBRandom) {
+	    victim = RandomNumber() % tlbWays;
+	} else {		// FIFO and LRU: the oldest stamp
+	    victim = 0;
+	    for (int i = 1; i < tlbWays; i++)
+		if (tlbStamp[first + i] < tlbStamp[first + victim])
+		    victim = i;
+	}
+    }
+    DEBUG(dbgAddr, "TLB load of page " << entry->virtualPage << " of space "
+			<< asid << " into entry " << first + victim);
+    set[victim] = *entry;
+    set[victim].asid = asid;
+    tlbStamp[first + victim] = ++tlbClock;
+}
+
+//----------------------------------------------------------------------
+// Machine::FlushTLB
+// 	Invalidate the TLB entries of address space "asid", eg, when
+//	it is deleted.
+//----------------------------------------------------------------------
+
+void
+Machine::FlushTLB(int asid)
+{
+    if (tlb == NULL)
+	return;
+    for (int i = 0; i < tlbSize; i++)
+	if (tlb[i].asid == asid)
+	    tlb[i].valid = FALSE;
+}
+
+//----------------------------------------------------------------------
+// Machine::InvalidateTranslations
+// 	Forget the page translations cached by the simulator (see
+//	Machine::HostAddress), so that the next access to every page
+//	goes through Translate.  The kernel must call this when it
+//	installs a page table or changes an entry of the current one.
+//----------------------------------------------------------------------
+
+void
+Machine::InvalidateTranslations()
+{
+    for (int i = 0; i < HostPageSlots; i++) {
+	hostPages[i].vpn = (unsigned int) -1;
+	hostPages[i].frame = NULL;
+	hostPages[i].writable = FALSE;
+    }
 }
 
 //----------------------------------------------------------------------
@@ -103,6 +221,8 @@ Machine::RaiseException(ExceptionType which, int badVAddr)
     DEBUG(dbgMach, "Exception: " << exceptionNames[which]);
     registers[BadVAddrReg] = badVAddr;
     DelayedLoad(0, 0);			// finish anything in progress
+    numTraps++;
+    CountTicks();			// charge the batch run so far
     kernel->interrupt->setStatus(SystemMode);
     ExceptionHandler(which);		// interrupts are enabled at this point
     kernel->interrupt->setStatus(UserMode);
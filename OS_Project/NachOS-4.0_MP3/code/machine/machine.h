@@ -39,6 +39,9 @@ const int NumPhysPages = 128;
 
 const int MemorySize = (NumPhysPages * PageSize);
 const int TLBSize = 4;			// if there is a TLB, make it small
+const int TLBWays = 4;			// ... and fully associative
+const int HostPageSlots = 32;		// translations of recently used
+					// pages kept by the simulator
 
 enum ExceptionType { NoException,           // Everything ok!
 		     SyscallException,      // A program executed a system call.
@@ -88,12 +91,37 @@ enum ExceptionType { NoException,           // Everything ok!
 // The procedures in this class are defined in machine.cc, mipssim.cc, and
 // translate.cc.
 
-class Instruction;
 class Interrupt;
+class Profile;
+
+// Which TLB entry of a set LoadTLB replaces, when none is free
+
+enum TLBPolicy { TLBRandom, TLBFifo, TLBLru };
+
+// The following class defines an instruction, represented in both
+// 	undecoded binary form
+//      decoded to identify
+//	    operation to do
+//	    registers to act on
+//	    any immediate operand value
+
+class Instruction {
+  public:
+    void Decode();	// decode the binary representation of the instruction
+
+    unsigned int value; // binary representation of the instruction
+
+    char opCode;     // Type of instruction.  This is NOT the same as the
+    		     // opcode field from the instruction: see defs in mips.h
+    char rs, rt, rd; // Three registers from instruction.
+    int extra;       // Immediate or target or shamt field or offset.
+                     // Immediates are sign-extended.
+};
 
 class Machine {
   public:
-    Machine(bool debug);	// Initialize the simulation of the hardware
+    Machine(bool debug, bool blocks = FALSE);
+				// Initialize the simulation of the hardware
 				// for running user programs
     ~Machine();			// De-allocate the data structures
 
@@ -137,23 +165,58 @@ class Machine {
 
     TranslationEntry *pageTable;
     unsigned int pageTableSize;
+    int currentAsid;			// with a TLB, the address space
+					// whose entries match
+    Profile *profile;			// if not NULL, counts the
+					// instructions of the running program
+
+// The TLB is "tlbSize" entries, in sets of "tlbWays"; a virtual page can
+// only be in set (vpn % number of sets).  The kernel loads entries with
+// LoadTLB after a PageFaultException, and need not flush the TLB on a
+// context switch, since entries are tagged with their address space.
+
+    void ConfigureTLB(int size, int ways, TLBPolicy policy);
+				// Change the shape of the TLB (and empty it)
+    void LoadTLB(TranslationEntry *entry, int asid);
+				// Put a page table entry into the TLB
+    void FlushTLB(int asid);	// Remove an address space's TLB entries
 
     bool ReadMem(int addr, int size, int* value);
     bool WriteMem(int addr, int size, int value);
     				// Read or write 1, 2, or 4 bytes of virtual 
 				// memory (at addr).  Return FALSE if a 
 				// correct translation couldn't be found.
+
+    void InvalidateTranslations();
+				// Forget the translations cached by the
+				// simulator; call whenever the page
+				// table or its entries change
   private:
 
 // Routines internal to the machine simulation -- DO NOT call these directly
     void DelayedLoad(int nextReg, int nextVal);  	
 				// Do a pending delayed load (modifying a reg)
 
-    void OneInstruction(Instruction *instr); 	
+    void OneInstruction(); 	
     				// Run one instruction of a user program.
+    Instruction *FetchInstruction();
+				// Decoded instruction at the PC, from
+				// the decoded-instruction cache
+    void Execute(Instruction *instr);
+				// Run a fetched instruction
+    int BlockLength(unsigned int start);
+				// Length of the basic block at a
+				// physical word
+    int RunBlock(int budget);	// Run the basic block at the PC
+    void CountTicks();		// Charge the ticks of instructions run
+				// without OneTick
     
 
 
+    char *HostAddress(int virtAddr, int size, bool writing);
+				// Host address of a virtual address, if
+				// its page translation is cached
+
     ExceptionType Translate(int virtAddr, int* physAddr, int size,bool writing);
     				// Translate an address, and check for 
 				// alignment.  Set the use and dirty bits in 
@@ -173,6 +236,31 @@ class Machine {
 
     int registers[NumTotalRegs]; // CPU registers, for executing user programs
 
+    Instruction *decodeCache;	// decoded form of every word of
+				// mainMemory, valid while its "value"
+				// matches memory
+    struct HostPage {		// a cached page table translation:
+	unsigned int vpn;	// virtual page number (-1 if unused),
+	char *frame;		// its frame in mainMemory, and
+	bool writable;		// has it been translated for writing?
+    } hostPages[HostPageSlots];	// direct mapped, by vpn
+    unsigned char *blockLength;	// length of the basic block starting
+				// at each word of mainMemory, 0 if not
+				// yet known
+
+    int tlbSize;		// number of TLB entries ...
+    int tlbWays;		// ... and entries per set
+    TLBPolicy tlbPolicy;	// which entry LoadTLB replaces
+    unsigned int *tlbStamp;	// when each entry was loaded (FIFO) or
+				// last used (LRU)
+    unsigned int tlbClock;	// advances on every stamp
+
+    bool useBlocks;		// run basic blocks between interrupt
+				// checks, when nothing is due
+    int numTraps;		// exceptions raised so far
+    int uncountedTicks;		// instructions run without OneTick, not
+				// yet added to the simulated time
+
     bool singleStep;		// drop back into the debugger after each
 				// simulated instruction
     int runUntilTime;		// drop back into the debugger when simulated
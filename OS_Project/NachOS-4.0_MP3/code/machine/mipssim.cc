@@ -21,28 +21,13 @@
 #include "machine.h"
 #include "mipssim.h"
 #include "main.h"
+#include "profile.h"
 
 static void Mult(int a, int b, bool signedArith, int* hiPtr, int* loPtr);
 
-// The following class defines an instruction, represented in both
-// 	undecoded binary form
-//      decoded to identify
-//	    operation to do
-//	    registers to act on
-//	    any immediate operand value
-
-class Instruction {
-  public:
-    void Decode();	// decode the binary representation of the instruction
-
-    unsigned int value; // binary representation of the instruction
-
-    char opCode;     // Type of instruction.  This is NOT the same as the
-    		     // opcode field from the instruction: see defs in mips.h
-    char rs, rt, rd; // Three registers from instruction.
-    int extra;       // Immediate or target or shamt field or offset.
-                     // Immediates are sign-extended.
-};
+// Longest basic block the block engine runs without re-checking
+// for interrupts (must fit in an unsigned char).
+static const int MaxBlockLength = 64;
 
 //----------------------------------------------------------------------
 // Machine::Run
@@ -51,20 +36,44 @@ class Instruction {
 //
 //	This routine is re-entrant, in that it can be called multiple
 //	times concurrently -- one for each thread executing user code.
+//
+//	While the interrupt simulation reports that nothing but the clock
+//	would change for a while (see Interrupt::QuietTicks), that many
+//	instructions are run without calling OneTick, and their ticks are
+//	charged in one go.  With the block engine ("useBlocks"), they are
+//	run a basic block at a time.  The last instruction of each such
+//	stretch -- or the one that traps -- is still followed by a full
+//	OneTick, so the kernel sees exactly the same timing as it would
+//	if OneTick were called after every instruction.
 //----------------------------------------------------------------------
 
 void
 Machine::Run()
 {
-    Instruction *instr = new Instruction;  // storage for decoded instruction
-
     if (debug->IsEnabled('m')) {
         cout << "Starting program in thread: " << kernel->currentThread->getName();
 		cout << ", at time: " << kernel->stats->totalTicks << "\n";
     }
     kernel->interrupt->setStatus(UserMode);
     for (;;) {
-        OneInstruction(instr);
+	int quiet = singleStep ? 0 : kernel->interrupt->QuietTicks();
+	int traps = numTraps;
+	int n;
+
+	while (quiet > 0 && numTraps == traps) {
+	    if (useBlocks && (n = RunBlock(quiet)) > 0) {
+		quiet -= n;
+	    } else if (numTraps == traps) {
+		OneInstruction();
+		if (numTraps == traps) {
+		    uncountedTicks++;
+		    quiet--;
+		}
+	    }
+	}
+	CountTicks();
+	if (numTraps == traps)		// else the trapping instruction
+	    OneInstruction();		// still needs its tick
 		kernel->interrupt->OneTick();
 		if (singleStep && (runUntilTime <= kernel->stats->totalTicks))
 	  		Debugger();
@@ -94,6 +103,179 @@ TypeToReg(RegType reg, Instruction *instr)
     }
 }
 
+//----------------------------------------------------------------------
+// Machine::FetchInstruction
+// 	Return the decoded instruction at the current PC, or NULL if the
+//	fetch raised an exception.
+//
+//	Decoded instructions are cached per physical word.  An entry is
+//	used only while the word in memory still equals the entry's
+//	"value", so stores into code (by the program, or by the kernel
+//	loading a new program into the frame) simply cause a re-decode.
+//
+//	The translation of the code page comes from the same cache as
+//	loads and stores (see Machine::HostAddress), so a loop within
+//	one page skips Translate.
+//----------------------------------------------------------------------
+
+Instruction *
+Machine::FetchInstruction()
+{
+    char *host = HostAddress(registers[PCReg], 4, FALSE);
+    int physicalAddress;
+    ExceptionType exception;
+    Instruction *instr;
+    unsigned int raw;
+
+    if (host != NULL) {
+	physicalAddress = host - mainMemory;
+    } else {
+	exception = Translate(registers[PCReg], &physicalAddress, 4, FALSE);
+	if (exception != NoException) {
+	    RaiseException(exception, registers[PCReg]);
+	    return NULL;
+	}
+    }
+
+    instr = &decodeCache[physicalAddress / 4];
+    raw = WordToHost(*(unsigned int *) &mainMemory[physicalAddress]);
+    if (instr->value != raw) {
+	instr->value = raw;
+	instr->Decode();
+	kernel->stats->numInstrDecodes++;
+    }
+    return instr;
+}
+
+//----------------------------------------------------------------------
+// IsBranch
+// 	Is this a branch or jump, ie, the end of a basic block (once its
+//	delay slot has executed)?
+//----------------------------------------------------------------------
+
+static bool
+IsBranch(Instruction *instr)
+{
+    switch (instr->opCode) {
+      case OP_BEQ: case OP_BGEZ: case OP_BGEZAL: case OP_BGTZ:
+      case OP_BLEZ: case OP_BLTZ: case OP_BLTZAL: case OP_BNE:
+      case OP_J: case OP_JAL: case OP_JALR: case OP_JR:
+	return TRUE;
+      default:
+	return FALSE;
+    }
+}
+
+//----------------------------------------------------------------------
+// Machine::BlockLength
+// 	Return the number of instructions in the basic block starting at
+//	physical word "start": up to and including the delay slot of the
+//	first branch or jump, or up to and including a syscall.  A block
+//	never crosses a page, since the next page may not be mapped to
+//	the next frame; a branch whose delay slot is on the next page is
+//	left out.  Returns 0 if there is no such block.
+//
+//	The length is remembered in "blockLength".  The decoded words are
+//	checked again every time the block runs (see RunBlock), which
+//	forgets the length if any of them has changed.
+//----------------------------------------------------------------------
+
+int
+Machine::BlockLength(unsigned int start)
+{
+    unsigned int end = (start / (PageSize / 4) + 1) * (PageSize / 4);
+    Instruction *instr;
+    unsigned int raw;
+    int length;
+
+    if (blockLength[start] != 0)
+	return blockLength[start];
+
+    for (length = 0; start + length < end && length < MaxBlockLength; ) {
+	instr = &decodeCache[start + length];
+	raw = WordToHost(*(unsigned int *) &mainMemory[(start + length) * 4]);
+	if (instr->value != raw) {
+	    instr->value = raw;
+	    instr->Decode();
+	    kernel->stats->numInstrDecodes++;
+	}
+	length++;
+	if (instr->opCode == OP_SYSCALL)
+	    break;
+	if (IsBranch(instr)) {
+	    if (start + length < end)
+		length++;		// the delay slot
+	    else
+		length--;		// slot is on the next page
+	    break;
+	}
+    }
+    blockLength[start] = length;
+    return length;
+}
+
+//----------------------------------------------------------------------
+// Machine::RunBlock
+// 	Run the basic block at the PC, if it has at most "budget"
+//	instructions, without calling OneTick in between.  Return how
+//	many instructions completed; their ticks are added to
+//	"uncountedTicks".
+//
+//	Before each instruction the PC and the word in memory are checked
+//	against the block, so control leaving the block early, or a store
+//	into it, ends the block there.  An exception ends it as well; the
+//	ticks run so far are charged before the kernel is entered (see
+//	RaiseException), so exceptions stay precise.  Returns 0 without
+//	running anything if the block does not fit, or the fetch trapped.
+//----------------------------------------------------------------------
+
+int
+Machine::RunBlock(int budget)
+{
+    Instruction *instr;
+    unsigned int start, raw;
+    int pc = registers[PCReg];
+    int traps = numTraps;
+    int length, i;
+
+    if ((instr = FetchInstruction()) == NULL)
+	return 0;			// exception occurred
+    start = instr - decodeCache;
+    length = BlockLength(start);
+    if (length == 0 || length > budget)
+	return 0;
+
+    for (i = 0; i < length; i++) {
+	instr = &decodeCache[start + i];
+	raw = WordToHost(*(unsigned int *) &mainMemory[(start + i) * 4]);
+	if (registers[PCReg] != pc + i * 4)
+	    break;			// left the block early
+	if (instr->value != raw) {
+	    blockLength[start] = 0;	// code changed: re-scan next time
+	    break;
+	}
+	Execute(instr);
+	if (numTraps != traps)
+	    break;			// the tick is charged by Run
+	uncountedTicks++;
+    }
+    return i;
+}
+
+//----------------------------------------------------------------------
+// Machine::CountTicks
+// 	Charge the ticks of instructions run without calling OneTick.
+//----------------------------------------------------------------------
+
+void
+Machine::CountTicks()
+{
+    if (uncountedTicks > 0) {
+	kernel->interrupt->AdvanceUserTicks(uncountedTicks);
+	uncountedTicks = 0;
+    }
+}
+
 //----------------------------------------------------------------------
 // Machine::OneInstruction
 // 	Execute one instruction from a user-level program
@@ -118,23 +300,34 @@ TypeToReg(RegType reg, Instruction *instr)
 //----------------------------------------------------------------------
 
 void
-Machine::OneInstruction(Instruction *instr)
+Machine::OneInstruction()
+{
+    Instruction *instr;
+
+    // Fetch instruction 
+    if ((instr = FetchInstruction()) == NULL)
+	return;			// exception occurred
+    Execute(instr);
+}
+
+//----------------------------------------------------------------------
+// Machine::Execute
+// 	Execute a decoded instruction, which was fetched from the PC.
+//	If it raises an exception, the machine state is left as it was
+//	before the instruction (apart from the delayed load).
+//----------------------------------------------------------------------
+
+void
+Machine::Execute(Instruction *instr)
 {
 #ifdef SIM_FIX
     int byte;       // described in Kane for LWL,LWR,...
 #endif
 
-    int raw;
     int nextLoadReg = 0; 	
     int nextLoadValue = 0; 	// record delayed load operation, to apply
 				// in the future
 
-    // Fetch instruction 
-    if (!ReadMem(registers[PCReg], 4, &raw))
-	return;			// exception occurred
-    instr->value = raw;
-    instr->Decode();
-
     if (debug->IsEnabled('m')) {
         struct OpString *str = &opStrings[instr->opCode];
 	char buf[80];
@@ -690,6 +883,14 @@ Machine::OneInstruction(Instruction *instr)
     
     // Now we have successfully executed the instruction.
     
+    if (profile != NULL) {		// count it, and follow calls
+	profile->Count(registers[PCReg]);
+	if (instr->opCode == OP_JAL || instr->opCode == OP_JALR)
+	    profile->Call(pcAfter);
+	else if (instr->opCode == OP_JR && instr->rs == R31)
+	    profile->Return();
+    }
+
     // Do any delayed load operation
     DelayedLoad(nextLoadReg, nextLoadValue);
     
@@ -10,6 +10,7 @@
 #include "copyright.h"
 #include "debug.h"
 #include "stats.h"
+#include "sysdep.h"
 
 //----------------------------------------------------------------------
 // Statistics::Statistics
@@ -22,6 +23,13 @@ Statistics::Statistics()
     numDiskReads = numDiskWrites = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
+    numInstrDecodes = 0;
+    numTLBHits = numTLBMisses = 0;
+    numMigrations = migrationTicks = 0;
+    numContextSwitches = numFairThreads = responseTicks = 0;
+    numPeriods = numDeadlineMisses = 0;
+    fairShareSum = fairShareSquares = 0;
+    hostStartTime = HostTime();
 }
 
 //----------------------------------------------------------------------
@@ -40,6 +48,38 @@ Statistics::Print()
 		cout << "Console I/O: reads " << numConsoleCharsRead;
     cout << ", writes " << numConsoleCharsWritten << "\n";
     cout << "Paging: faults " << numPageFaults << "\n";
+    if (numTLBHits + numTLBMisses > 0) {
+		cout << "TLB: hits " << numTLBHits << ", misses " << numTLBMisses;
+		cout << ", hit rate " << 100.0 * numTLBHits / (numTLBHits + numTLBMisses) << "%\n";
+    }
+    cout << "Scheduling: context switches " << numContextSwitches;
+    if (totalTicks > 0)		// taking a tick to be a microsecond
+		cout << " (" << 1e6 * numContextSwitches / totalTicks << " per second)";
+    if (numContextSwitches > 0)
+		cout << ", mean response " << (double) responseTicks / numContextSwitches << " ticks";
+    if (numFairThreads > 0) {		// 1 if every thread got the same
+		cout << ", fairness " << fairShareSum * fairShareSum
+			/ (numFairThreads * fairShareSquares);
+		cout << " over " << numFairThreads << " threads";
+    }
+    cout << "\n";
+    if (numPeriods > 0) {
+		cout << "Real-time: periods " << numPeriods;
+		cout << ", deadline misses " << numDeadlineMisses << "\n";
+    }
+    if (numMigrations > 0) {
+		cout << "Migrations: " << numMigrations;
+		cout << ", cost " << migrationTicks << " ticks\n";
+    }
     cout << "Network I/O: packets received " << numPacketsRecvd;
 		cout << ", sent " << numPacketsSent << "\n";
+
+    cout << "User instructions: " << userTicks;
+		cout << ", decoded " << numInstrDecodes << "\n";
+
+    // the speed of the simulation depends on the host, so it is only
+    // printed when asked for, to keep the statistics above repeatable
+    double seconds = HostTime() - hostStartTime;
+    if (seconds > 0)
+		DEBUG(dbgMach, "Simulated MIPS " << userTicks / seconds / 1e6);
 }
@@ -35,6 +35,25 @@ class Statistics {
     int numPageFaults;		// number of virtual memory page faults
     int numPacketsSent;		// number of packets sent over the network
     int numPacketsRecvd;	// number of packets received over the network
+    int numInstrDecodes;	// number of user instructions decoded
+				// (misses in the decoded-instruction cache)
+    int numTLBHits;		// number of translations found in the TLB
+    int numTLBMisses;		// number of translations not in the TLB
+    int numMigrations;		// number of times a thread ran on a
+				// different CPU than it last ran on
+    int migrationTicks;		// time spent refilling the caches of
+				// threads that moved
+    int numContextSwitches;	// number of times a CPU changed threads
+    int responseTicks;		// time the threads switched to had
+				// waited, ready, to run
+    int numPeriods;		// number of real-time periods that ended
+    int numDeadlineMisses;	// how many of those, the thread had not
+				// yet had its budget
+    int numFairThreads;		// threads whose share of the CPU, while
+    double fairShareSum;	// they could run, per unit of weight,
+    double fairShareSquares;	// went into Jain's fairness index
+    double hostStartTime;	// host time (in seconds) at startup, to
+				// report simulated instructions per second
 
     Statistics(); 		// initialize everything to zero
 
@@ -56,5 +75,7 @@ const int SeekTime =	 500;  	// time disk takes to seek past one track
 const int ConsoleTime =	 100;	// time to read or write one character
 const int NetworkTime =	 100;  	// time to send or receive one packet
 const int TimerTicks = 	 100;  	// (average) time between timer interrupts
+const int AgingTicks =	1500;	// time in a ready queue before a thread
+				// gains priority
 
 #endif // STATS_H
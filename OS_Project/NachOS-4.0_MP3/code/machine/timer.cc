@@ -40,6 +40,7 @@ Timer::Timer(bool doRandom, CallBackObj *toCall)
     randomize = doRandom;
     callPeriodically = toCall;
     disable = FALSE;
+    suspended = FALSE;
     SetInterrupt();
 }
 
@@ -62,8 +63,8 @@ Timer::CallBack()
 //----------------------------------------------------------------------
 // Timer::SetInterrupt
 //      Cause a timer interrupt to occur in the future, unless
-//	future interrupts have been disabled.  The delay is either
-//	fixed or random.
+//	future interrupts have been disabled or suspended.  The delay
+//	is either fixed or random.
 //----------------------------------------------------------------------
 
 void
@@ -75,7 +76,36 @@ Timer::SetInterrupt()
        if (randomize) {
 	     delay = 1 + (RandomNumber() % (TimerTicks * 2));
         }
+       nextTime = kernel->stats->totalTicks + delay;
        // schedule the next timer device interrupt
-       kernel->interrupt->Schedule(this, delay, TimerInt);
+       if (!suspended)
+	   kernel->interrupt->Schedule(this, delay, TimerInt);
     }
 }
+
+//----------------------------------------------------------------------
+// Timer::Resume
+//      Start generating interrupts again after Suspend.  A fixed
+//	interval timer picks up at the next time that it would have
+//	interrupted if it had not been suspended, so that suspending it
+//	only leaves out the interrupts in between.
+//----------------------------------------------------------------------
+
+void
+Timer::Resume()
+{
+    int now = kernel->stats->totalTicks;
+
+    if (!suspended)
+	return;
+    suspended = FALSE;
+    if (disable)
+	return;
+    if (nextTime <= now) {
+	if (randomize)
+	    nextTime = now + 1 + (RandomNumber() % (TimerTicks * 2));
+	else
+	    nextTime += ((now - nextTime) / TimerTicks + 1) * TimerTicks;
+    }
+    kernel->interrupt->Schedule(this, nextTime - now, TimerInt);
+}
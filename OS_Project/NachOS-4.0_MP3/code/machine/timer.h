@@ -36,11 +36,20 @@ class Timer : public CallBackObj {
     				// Turn timer device off, so it doesn't
 				// generate any more interrupts.
 
+    void Suspend() { suspended = TRUE; }
+				// Generate no interrupts after the next
+				// one, until Resume
+    void Resume();		// Start generating interrupts again,
+				// at the times they would have occurred
+
   private:
     bool randomize;		// set if we need to use a random timeout delay
     CallBackObj *callPeriodically; // call this every TimerTicks time units 
     bool disable;		// turn off the timer device after next
     				// interrupt.
+    bool suspended;		// don't schedule the next interrupt
+    int nextTime;		// when the next interrupt is (or would be)
+				// due
     
     void CallBack();		// called internally when the hardware
 				// timer generates an interrupt
@@ -88,7 +88,21 @@ Machine::ReadMem(int addr, int size, int *value)
     int data;
     ExceptionType exception;
     int physicalAddress;
+    char *host;
     
+    if ((host = HostAddress(addr, size, FALSE)) != NULL) {
+	switch (size) {
+	  case 1:
+	    *value = *host;
+	    return TRUE;
+	  case 2:
+	    *value = ShortToHost(*(unsigned short *) host);
+	    return TRUE;
+	  case 4:
+	    *value = WordToHost(*(unsigned int *) host);
+	    return TRUE;
+	}
+    }
     DEBUG(dbgAddr, "Reading VA " << addr << ", size " << size);
     
     exception = Translate(addr, &physicalAddress, size, FALSE);
@@ -137,7 +151,22 @@ Machine::WriteMem(int addr, int size, int value)
 {
     ExceptionType exception;
     int physicalAddress;
+    char *host;
      
+    if ((host = HostAddress(addr, size, TRUE)) != NULL) {
+	switch (size) {
+	  case 1:
+	    *host = (unsigned char) (value & 0xff);
+	    return TRUE;
+	  case 2:
+	    *(unsigned short *) host
+		= ShortToMachine((unsigned short) (value & 0xffff));
+	    return TRUE;
+	  case 4:
+	    *(unsigned int *) host = WordToMachine((unsigned int) value);
+	    return TRUE;
+	}
+    }
     DEBUG(dbgAddr, "Writing VA " << addr << ", size " << size << ", value " << value);
 
     exception = Translate(addr, &physicalAddress, size, TRUE);
@@ -166,6 +195,35 @@ Machine::WriteMem(int addr, int size, int value)
     return TRUE;
 }
 
+//----------------------------------------------------------------------
+// Machine::HostAddress
+// 	Return where in mainMemory the virtual address "virtAddr" is, if
+//	the translation of its page is cached and the access needs no
+//	checks by Translate; otherwise return NULL.
+//
+//	Translate caches every successful page table translation.  It is
+//	only used for writing if it was made for writing, so that the
+//	dirty bit (like the use bit) is set on the first access.  Nothing
+//	is cached with a TLB, since the kernel may change it at any time,
+//	or while address translation is being debugged.
+//
+//	"virtAddr" -- the virtual address to translate
+//	"size" -- the amount of memory being read or written
+// 	"writing" -- if TRUE, the page must be writable
+//----------------------------------------------------------------------
+
+char *
+Machine::HostAddress(int virtAddr, int size, bool writing)
+{
+    unsigned int vpn = (unsigned) virtAddr / PageSize;
+    HostPage *slot = &hostPages[vpn % HostPageSlots];
+
+    if (slot->vpn != vpn || (virtAddr & (size - 1)) != 0
+				|| (writing && !slot->writable))
+	return NULL;
+    return slot->frame + (unsigned) virtAddr % PageSize;
+}
+
 //----------------------------------------------------------------------
 // Machine::Translate
 // 	Translate a virtual address into a physical address, using 
@@ -214,18 +272,25 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 	    return PageFaultException;
 	}
 	entry = &pageTable[vpn];
-    } else {
-        for (entry = NULL, i = 0; i < TLBSize; i++)
-    	    if (tlb[i].valid && (tlb[i].virtualPage == ((int)vpn))) {
+    } else {			// => search the entry's set of the TLB
+	int first = (vpn % (tlbSize / tlbWays)) * tlbWays;
+
+        for (entry = NULL, i = first; i < first + tlbWays; i++)
+    	    if (tlb[i].valid && (tlb[i].virtualPage == ((int)vpn))
+					&& tlb[i].asid == currentAsid) {
 		entry = &tlb[i];			// FOUND!
+		if (tlbPolicy == TLBLru)
+		    tlbStamp[i] = ++tlbClock;
 		break;
 	    }
 	if (entry == NULL) {				// not found
     	    DEBUG(dbgAddr, "Invalid TLB entry for this virtual page!");
+	    kernel->stats->numTLBMisses++;
     	    return PageFaultException;		// really, this is a TLB fault,
 						// the page may be in memory,
 						// but not in the TLB
 	}
+	kernel->stats->numTLBHits++;
     }
 
     if (entry->readOnly && writing) {	// trying to write to a read-only page
@@ -246,5 +311,13 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
     *physAddr = pageFrame * PageSize + offset;
     ASSERT((*physAddr >= 0) && ((*physAddr + size) <= MemorySize));
     DEBUG(dbgAddr, "phys addr = " << *physAddr);
+
+    if (tlb == NULL && !debug->IsEnabled(dbgAddr)) {	// see HostAddress
+	HostPage *slot = &hostPages[vpn % HostPageSlots];
+
+	slot->writable = writing || (slot->vpn == vpn && slot->writable);
+	slot->vpn = vpn;
+	slot->frame = &mainMemory[pageFrame * PageSize];
+    }
     return NoException;
 }
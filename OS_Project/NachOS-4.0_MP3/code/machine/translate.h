@@ -40,6 +40,8 @@ class TranslationEntry {
 			// page is referenced or modified.
     bool dirty;         // This bit is set by the hardware every time the
 			// page is modified.
+    int asid;		// In a TLB, the address space the entry belongs
+			// to; only entries of the current one match.
 };
 
 #endif
@@ -0,0 +1,405 @@
+// cpu.cc
+//	Routines to simulate a multiprocessor: switching the host between
+//	the simulated CPUs, keeping idle CPUs in step with busy ones, and
+//	moving ready threads to CPUs that have nothing to run.
+//	See cpu.h.
+//
+//	These routines assume interrupts are disabled, except where noted,
+//	just like the scheduler's.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "cpu.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// CPUStart
+// 	The first thread to run on each CPU but the first.  It has nothing
+//	to do: it finishes right away, and the CPU idles in it until there
+//	is a real thread to run.
+//----------------------------------------------------------------------
+
+static void
+CPUStart(void *arg)
+{
+}
+
+//----------------------------------------------------------------------
+// CPU::CPU
+// 	Initialize the state of one CPU.
+//
+//	"cpuNumber" -- which CPU this is
+//	"readyQueue" -- the scheduler holding its ready threads
+//----------------------------------------------------------------------
+
+CPU::CPU(int cpuNumber, Scheduler *readyQueue)
+{
+    number = cpuNumber;
+    scheduler = readyQueue;
+    currentThread = NULL;
+    clock = 0;
+    status = SystemMode;
+    idle = FALSE;
+    idleTicks = 0;
+    migrations = 0;
+    steals = 0;
+    remoteWakeups = 0;
+}
+
+//----------------------------------------------------------------------
+// CPUSet::CPUSet
+// 	Set up "count" CPUs.  CPU 0 is the one Nachos started on: it has
+//	the main thread and the kernel's scheduler.  Each of the others
+//	gets a scheduler of its own, and a thread to start in.
+//----------------------------------------------------------------------
+
+CPUSet::CPUSet(int count)
+{
+    ASSERT(count >= 1 && count <= MaxCPUs);
+    numCPUs = count;
+    cpus[0] = new CPU(0, kernel->scheduler);
+    kernel->currentThread->setCPU(0);
+    for (int i = 1; i < numCPUs; i++) {
+	Thread *start = new Thread("cpu start", -1);
+
+	cpus[i] = new CPU(i, new Scheduler(i));
+	cpus[i]->scheduler->setSchedulerType(
+			kernel->scheduler->getSchedulerType());
+	start->StackAllocate(CPUStart, NULL);
+	start->setStatus(RUNNING);
+	start->setCPU(i);
+	cpus[i]->currentThread = start;
+	cpus[i]->idle = TRUE;
+    }
+    current = cpus[0];
+}
+
+//----------------------------------------------------------------------
+// CPUSet::~CPUSet
+// 	De-allocate the CPUs, and their schedulers.
+//----------------------------------------------------------------------
+
+CPUSet::~CPUSet()
+{
+    for (int i = 0; i < numCPUs; i++) {
+	delete cpus[i]->scheduler;
+	delete cpus[i];
+    }
+}
+
+//----------------------------------------------------------------------
+// Stealable
+// 	Return how many of the threads on CPU "c"'s ready queue another
+//	CPU may take: not real-time threads, and not a thread that CPU
+//	"c" is idling in, even once it is ready, because its stack is in
+//	use.
+//----------------------------------------------------------------------
+
+static int
+Stealable(CPU *c, CPU *current)
+{
+    int n = c->scheduler->NumMovable();
+
+    if (c != current && c->currentThread->getStatus() == READY
+		&& !c->currentThread->IsRealTime())
+	n--;
+    return n;
+}
+
+//----------------------------------------------------------------------
+// HasWork
+// 	Return TRUE if CPU "c", if it ran now, would find a thread to run:
+//	one of its own, or one to take from another CPU.
+//----------------------------------------------------------------------
+
+static bool
+HasWork(CPU *c, CPU **cpus, int numCPUs, CPU *current)
+{
+    if (c->scheduler->FindNext() != NULL)
+	return TRUE;
+    for (int i = 0; i < numCPUs; i++)
+	if (cpus[i] != c && Stealable(cpus[i], current) > 0)
+	    return TRUE;
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// CPUSet::Behind
+// 	Return the CPU, other than the current one, whose clock is
+//	earliest, or NULL if there is only one CPU.
+//
+//	"needWork" -- if TRUE, skip idle CPUs that would stay idle
+//----------------------------------------------------------------------
+
+CPU *
+CPUSet::Behind(bool needWork)
+{
+    CPU *behind = NULL;
+
+    for (int i = 0; i < numCPUs; i++) {
+	CPU *c = cpus[i];
+
+	if (c == current)
+	    continue;
+	if (needWork && c->idle && !HasWork(c, cpus, numCPUs, current))
+	    continue;
+	if (behind == NULL || c->clock < behind->clock)
+	    behind = c;
+    }
+    return behind;
+}
+
+//----------------------------------------------------------------------
+// CPUSet::NextSwitch
+// 	Return the time at which the current CPU will be more than
+//	CPUQuantum ticks ahead of some other CPU.  Interrupts may be on.
+//----------------------------------------------------------------------
+
+int
+CPUSet::NextSwitch()
+{
+    CPU *behind = Behind(FALSE);
+
+    ASSERT(behind != NULL);
+    return behind->clock + CPUQuantum + 1;
+}
+
+//----------------------------------------------------------------------
+// CPUSet::NeedSwitch
+// 	Return TRUE if another CPU has fallen too far behind the current
+//	one, and should run.  Called on every clock tick, so it returns
+//	quickly unless some CPU is CPUQuantum ticks behind.
+//
+//	Idle CPUs that would find nothing to run if they did are brought
+//	up to the current time instead.
+//----------------------------------------------------------------------
+
+bool
+CPUSet::NeedSwitch()
+{
+    Statistics *stats = kernel->stats;
+    int now = stats->totalTicks;
+
+    if (numCPUs == 1 || NextSwitch() > now)
+	return FALSE;
+    for (int i = 0; i < numCPUs; i++) {
+	CPU *c = cpus[i];
+
+	if (c != current && c->idle && c->clock < now
+			&& !HasWork(c, cpus, numCPUs, current)) {
+	    c->idleTicks += now - c->clock;
+	    stats->idleTicks += now - c->clock;
+	    c->clock = now;
+	}
+    }
+    return NextSwitch() <= now;
+}
+
+//----------------------------------------------------------------------
+// CPUSet::Switch
+// 	Let the CPU that is furthest behind, and has something to do, run.
+//	Returns when some CPU switches back to this one.  Interrupts may
+//	be on.
+//----------------------------------------------------------------------
+
+void
+CPUSet::Switch()
+{
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+    CPU *next = Behind(TRUE);
+
+    if (next != NULL)
+	SwitchTo(next);
+    (void) kernel->interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// CPUSet::Idle
+// 	The current CPU has nothing to run.  If some other CPU has, bring
+//	our clock up to its time, and let it run; return TRUE once some
+//	CPU switches back to us, to check again for something to run.
+//
+//	Return FALSE if no CPU has anything to do: then the caller must
+//	wait for an interrupt.
+//----------------------------------------------------------------------
+
+bool
+CPUSet::Idle()
+{
+    Statistics *stats = kernel->stats;
+    CPU *next;
+
+    if (numCPUs == 1 || (next = Behind(TRUE)) == NULL)
+	return FALSE;
+    if (next->clock > stats->totalTicks) {
+	current->idleTicks += next->clock - stats->totalTicks;
+	stats->idleTicks += next->clock - stats->totalTicks;
+	stats->totalTicks = next->clock;
+    }
+    current->idle = TRUE;
+    SwitchTo(next);
+    current->idle = FALSE;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// CPUSet::Steal
+// 	The current CPU has nothing in its ready queue.  Take half the
+//	threads another CPU could spare -- from the CPU with the most --
+//	put them on our ready queue, and return the first to run.  Return
+//	NULL if no CPU has a thread to spare.
+//
+//	Threads whose caches are still warm on their CPU are left there,
+//	unless there is nothing else to take.
+//----------------------------------------------------------------------
+
+Thread *
+CPUSet::Steal()
+{
+    Scheduler *scheduler = kernel->scheduler;
+    CPU *victim = NULL;
+    Thread *keep, *thread;
+    int most = 0, n = 0;
+
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+    ASSERT(scheduler->NumReady() == 0);
+    for (int i = 1; i < numCPUs; i++) {
+	CPU *c = cpus[(current->number + i) % numCPUs];
+
+	if (Stealable(c, current) > most) {
+	    victim = c;
+	    most = Stealable(c, current);
+	}
+    }
+    if (victim == NULL)
+	return NULL;
+
+    keep = victim->currentThread;	// ready, if it is, but parked
+    while (n < (most + 1) / 2
+		&& (thread = victim->scheduler->RemoveLast(keep, TRUE)) != NULL) {
+	scheduler->Adopt(thread);
+	n++;
+    }
+    if (n == 0) {			// all warm: take one anyway
+	scheduler->Adopt(victim->scheduler->RemoveLast(keep, FALSE));
+	n++;
+    }
+    DEBUG(dbgThread, "CPU " << current->number << " takes " << n << " threads from CPU " << victim->number);
+    current->steals++;
+    return scheduler->FindNextToRun();
+}
+
+//----------------------------------------------------------------------
+// CPUSet::MigrationTicks
+// 	Return the time it would take "thread" to refill its cache, if it
+//	ran now on a CPU other than the one it last ran on.  The longer it
+//	has been since it ran, the less of its cache is left to lose.
+//	(The CPU it left may be ahead of this one: then it left just now.)
+//----------------------------------------------------------------------
+
+int
+CPUSet::MigrationTicks(Thread *thread)
+{
+    int away = max(kernel->stats->totalTicks - thread->getLastRan(), 0);
+
+    if (thread->getCPU() < 0 || away >= CacheHotTicks)
+	return 0;
+    return MigrationCost * (CacheHotTicks - away) / CacheHotTicks;
+}
+
+//----------------------------------------------------------------------
+// CPUSet::AnyReady
+// 	Return TRUE if there is a ready thread on any CPU.
+//----------------------------------------------------------------------
+
+bool
+CPUSet::AnyReady()
+{
+    for (int i = 0; i < numCPUs; i++)
+	if (cpus[i]->scheduler->FindNext() != NULL)
+	    return TRUE;
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// CPUSet::SwitchTo
+// 	Save the state of the current CPU, and hand the host to CPU
+//	"next": its thread, scheduler, clock and mode become the kernel's.
+//
+//	This is like Scheduler::Run, except that the thread we leave stays
+//	on this CPU, in whatever state it is in: we come back to it, right
+//	here, when some CPU switches back to this one.
+//----------------------------------------------------------------------
+
+void
+CPUSet::SwitchTo(CPU *next)
+{
+    Interrupt *interrupt = kernel->interrupt;
+    Thread *oldThread = kernel->currentThread;
+    Thread *nextThread = next->currentThread;
+
+    ASSERT(interrupt->getLevel() == IntOff);
+    ASSERT(next != current);
+
+    if (oldThread->space != NULL) {	// if this thread is a user program,
+	oldThread->SaveUserState();	// save the user's CPU registers
+	oldThread->space->SaveState();
+    }
+    current->currentThread = oldThread;
+    current->clock = kernel->stats->totalTicks;
+    current->status = interrupt->getStatus();
+
+    DEBUG(dbgThread, "Switching from CPU " << current->number << " to CPU " << next->number);
+    current = next;
+    kernel->currentThread = nextThread;
+    kernel->scheduler = next->scheduler;
+    kernel->stats->totalTicks = next->clock;
+    interrupt->setStatus(next->status);
+    kernel->alarm->SetActive(next->scheduler->TimeSliced(nextThread));
+    kernel->alarm->StartSlice(nextThread);	// as Scheduler::Run does
+    SWITCH(oldThread, nextThread);
+
+    // we're back, on this CPU; whoever switched to it has set up
+    // the kernel's thread, scheduler, clock and mode
+    ASSERT(kernel->currentThread == oldThread);
+    if (oldThread->space != NULL) {
+	oldThread->RestoreUserState();
+	oldThread->space->RestoreState();
+    }
+}
+
+//----------------------------------------------------------------------
+// CPUSet::Report
+// 	Print how busy each CPU was, and how many threads moved between
+//	CPUs.  CPUs that are behind are taken to have idled to the end,
+//	and the kernel's clock is set to the end, so that the total time
+//	printed afterwards is the time the whole machine ran.
+//----------------------------------------------------------------------
+
+void
+CPUSet::Report()
+{
+    Statistics *stats = kernel->stats;
+    int end = stats->totalTicks;
+
+    current->clock = stats->totalTicks;
+    for (int i = 0; i < numCPUs; i++)
+	end = max(end, cpus[i]->clock);
+    for (int i = 0; i < numCPUs; i++) {
+	CPU *c = cpus[i];
+	int idle = c->idleTicks + (end - c->clock);
+
+	stats->idleTicks += end - c->clock;
+	cout << "CPU " << i << ": busy " << end - idle << ", idle " << idle;
+	if (end > 0)
+	    cout << ", utilization " << 100.0 * (end - idle) / end << "%";
+	cout << "\n";
+	cout << "CPU " << i << ": migrations in " << c->migrations;
+	cout << ", steals " << c->steals;
+	cout << ", remote wakeups " << c->remoteWakeups << "\n";
+    }
+    stats->totalTicks = end;
+}
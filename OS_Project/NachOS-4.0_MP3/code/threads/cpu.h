@@ -0,0 +1,114 @@
+// cpu.h
+//	Data structures to simulate a multiprocessor.
+//
+//	With "-cpus N", Nachos simulates N CPUs.  Each has its own
+//	current thread, ready queue (a Scheduler), and clock.  Only one
+//	of them -- the "current" CPU -- actually executes at a time: it
+//	owns the simulated machine, kernel->currentThread, kernel->scheduler
+//	and kernel->stats->totalTicks.  The others are parked in the
+//	middle of a context switch, with their state saved here.
+//
+//	The CPUs are interleaved deterministically: the current CPU runs
+//	until its clock is CPUQuantum ticks ahead of the CPU that is
+//	furthest behind, and then hands the host over to that CPU.  A CPU
+//	with nothing to do keeps up with the others by jumping its clock
+//	forward.  So simulated time advances on all CPUs together, and a
+//	workload with N runnable threads finishes in about 1/N the ticks.
+//	Events (interrupts, wakeups) can be seen up to CPUQuantum ticks
+//	late on a CPU that is behind.
+//
+//	Threads run on the CPU they last ran on: a thread woken up by
+//	another CPU is put on its own CPU's ready queue, where its cache
+//	may still be warm.  A CPU that has nothing to run takes half the
+//	ready threads of the busiest CPU, from the end of its queue that
+//	it would run last, preferring threads whose caches have gone cold.
+//	A thread that moves anyway pays for refilling its cache: up to
+//	MigrationCost ticks, less the longer it has been off its CPU.
+//
+//	With one CPU (the default) none of this does anything.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef CPU_H
+#define CPU_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "interrupt.h"
+
+class Thread;
+class Scheduler;
+
+// The most CPUs we can simulate
+const int MaxCPUs = 8;
+
+// How far ahead of the others a CPU may run, in ticks
+const int CPUQuantum = 100;
+
+// What moving a thread costs: the time to refill a cache the thread
+// left just now, and how long until its cache is no longer worth
+// anything
+const int MigrationCost = 50;
+const int CacheHotTicks = 500;
+
+// The following class defines the state of one simulated CPU.
+
+class CPU {
+  public:
+    CPU(int cpuNumber, Scheduler *readyQueue);
+
+    int number;			// which CPU this is, 0 .. N-1
+    Scheduler *scheduler;	// threads ready to run on this CPU
+    Thread *currentThread;	// the thread on this CPU, if it isn't
+				// the current CPU
+    int clock;			// this CPU's time, if it isn't the
+				// current CPU
+    MachineStatus status;	// idle, kernel or user mode, likewise
+    bool idle;			// nothing to run on this CPU?
+
+    int idleTicks;		// time with nothing to run
+    int migrations;		// threads that came from another CPU
+    int steals;			// times it took threads from another
+				// CPU's queue
+    int remoteWakeups;		// threads woken up by another CPU
+};
+
+// The following class defines the set of CPUs, and switching the
+// host between them.
+
+class CPUSet {
+  public:
+    CPUSet(int count);		// CPU 0 is the one we are running on;
+				// the others start out idle
+    ~CPUSet();
+
+    int NumCPUs() { return numCPUs; }
+    CPU *Current() { return current; }
+    CPU *Get(int i) { ASSERT(i >= 0 && i < numCPUs); return cpus[i]; }
+
+    bool NeedSwitch();		// is another CPU too far behind?
+    int NextSwitch();		// time at which one will be
+    void Switch();		// let the CPU furthest behind run
+
+    bool Idle();		// nothing to run here: let another CPU
+				// run, if any has something to do
+    Thread *Steal();		// take ready threads from another CPU,
+				// and return one to run
+    int MigrationTicks(Thread *thread);
+				// cost of running thread on another CPU
+    bool AnyReady();		// is any thread ready, on any CPU?
+
+    void Report();		// print per-CPU statistics
+
+  private:
+    int numCPUs;
+    CPU *cpus[MaxCPUs];
+    CPU *current;		// the CPU the host is running
+
+    CPU *Behind(bool needWork);	// the CPU with the earliest clock
+    void SwitchTo(CPU *next);	// hand the host to "next"
+};
+
+#endif // CPU_H
@@ -17,6 +17,7 @@
 #include "synchdisk.h"
 #include "post.h"
 #include "synchconsole.h"
+#include "syscall.h"
 
 //----------------------------------------------------------------------
 // Kernel::Kernel
@@ -29,6 +30,16 @@ Kernel::Kernel(int argc, char **argv)
     priorityEnabled = FALSE;
     randomSlice = FALSE; 
     debugUserProg = FALSE;
+    useBlocks = FALSE;
+    profileUserProg = FALSE;
+    numCPUs = 1;
+    schedulerType = MultiLevel;
+    traceMode = TraceText;	// print the scheduler's decisions
+    traceFile = NULL;
+    quantum = TimerTicks;	// yield at every timer interrupt
+#ifdef USE_TLB
+    tlbEntries = 0;             // default TLB shape
+#endif
     consoleIn = NULL;          // default is stdin
     consoleOut = NULL;         // default is stdout
 #ifndef FILESYS_STUB
@@ -46,6 +57,44 @@ Kernel::Kernel(int argc, char **argv)
 	    	i++;
         } else if (strcmp(argv[i], "-s") == 0) {
             debugUserProg = TRUE;
+        } else if (strcmp(argv[i], "-bb") == 0) {
+            useBlocks = TRUE;
+        } else if (strcmp(argv[i], "-prof") == 0) {
+            profileUserProg = TRUE;
+        } else if (strcmp(argv[i], "-cpus") == 0) {
+            ASSERT(i + 1 < argc);   // next argument is the number of CPUs
+            numCPUs = atoi(argv[i + 1]);
+            ASSERT(numCPUs >= 1 && numCPUs <= MaxCPUs);
+            i++;
+        } else if (strcmp(argv[i], "-sched") == 0) {
+            ASSERT(i + 1 < argc);   // mlfq, rr or cfs
+            if (strcmp(argv[i + 1], "rr") == 0)
+                schedulerType = RoundRobin;
+            else if (strcmp(argv[i + 1], "cfs") == 0)
+                schedulerType = Fair;
+            else
+                schedulerType = MultiLevel;
+            i++;
+        } else if (strcmp(argv[i], "-quantum") == 0) {
+            ASSERT(i + 1 < argc);   // ticks, or adaptive
+            if (strcmp(argv[i + 1], "adaptive") == 0)
+                quantum = 0;
+            else {
+                quantum = atoi(argv[i + 1]);
+                ASSERT(quantum > 0);
+            }
+            i++;
+        } else if (strcmp(argv[i], "-trace") == 0) {
+            ASSERT(i + 1 < argc);   // off, text, or a file for binary
+            if (strcmp(argv[i + 1], "off") == 0)
+                traceMode = TraceOff;
+            else if (strcmp(argv[i + 1], "text") == 0)
+                traceMode = TraceText;
+            else {
+                traceMode = TraceBinary;
+                traceFile = argv[i + 1];
+            }
+            i++;
 		} else if (strcmp(argv[i], "-e") == 0) {
         	execfile[++execfileNum]= argv[++i];
 			cout << execfile[execfileNum] << "\n";
@@ -57,6 +106,19 @@ Kernel::Kernel(int argc, char **argv)
 	    	ASSERT(i + 1 < argc);
 	    	consoleOut = argv[i + 1];
 	    	i++;
+#ifdef USE_TLB
+        } else if (strcmp(argv[i], "-tlb") == 0) {
+            ASSERT(i + 3 < argc);   // size, ways, replacement policy
+            tlbEntries = atoi(argv[i + 1]);
+            tlbWays = atoi(argv[i + 2]);
+            if (strcmp(argv[i + 3], "lru") == 0)
+                tlbPolicy = TLBLru;
+            else if (strcmp(argv[i + 3], "fifo") == 0)
+                tlbPolicy = TLBFifo;
+            else
+                tlbPolicy = TLBRandom;
+            i += 3;
+#endif
 #ifndef FILESYS_STUB
 		} else if (strcmp(argv[i], "-f") == 0) {
 	    	formatFlag = TRUE;
@@ -72,6 +134,13 @@ Kernel::Kernel(int argc, char **argv)
         } else if (strcmp(argv[i], "-u") == 0) {
             cout << "Partial usage: nachos [-rs randomSeed]\n";
 	   		cout << "Partial usage: nachos [-s]\n";
+            cout << "Partial usage: nachos [-bb] [-prof] [-cpus #]\n";
+            cout << "Partial usage: nachos [-sched mlfq|rr|cfs]\n";
+            cout << "Partial usage: nachos [-trace off|text|traceFile]\n";
+            cout << "Partial usage: nachos [-quantum #|adaptive]\n";
+#ifdef USE_TLB
+            cout << "Partial usage: nachos [-tlb size ways lru|fifo|random]\n";
+#endif
             cout << "Partial usage: nachos [-ci consoleIn] [-co consoleOut]\n";
 #ifndef FILESYS_STUB
 	    	cout << "Partial usage: nachos [-nf]\n";
@@ -106,10 +175,19 @@ Kernel::Initialize()
     currentThread->setStatus(RUNNING);
     currentThread->setExecPriority(200);
     stats = new Statistics();		// collect statistics
+    stackPool = new StackPool();	// recycle thread stacks
     interrupt = new Interrupt;		// start up interrupt handling
+    trace = new SchedTrace(traceMode, traceFile);
     scheduler = new Scheduler();	// initialize the ready queue
+    scheduler->setSchedulerType(schedulerType);
+    cpus = new CPUSet(numCPUs);		// and the other CPUs, if any
     alarm = new Alarm(randomSlice);	// start up time slicing
-    machine = new Machine(debugUserProg);
+    alarm->SetQuantum(quantum);
+    machine = new Machine(debugUserProg, useBlocks);
+#ifdef USE_TLB
+    if (tlbEntries > 0)
+        machine->ConfigureTLB(tlbEntries, tlbWays, tlbPolicy);
+#endif
     synchConsoleIn = new SynchConsoleInput(consoleIn); // input from stdin
     synchConsoleOut = new SynchConsoleOutput(consoleOut); // output to stdout
     synchDisk = new SynchDisk();    //
@@ -133,7 +211,8 @@ Kernel::~Kernel()
 {
     delete stats;
     delete interrupt;
-    delete scheduler;
+    delete cpus;			// and their schedulers
+    delete trace;			// writing out the rest of it
     delete alarm;
     delete machine;
     delete synchConsoleIn;
@@ -142,6 +221,7 @@ Kernel::~Kernel()
     delete fileSystem;
     delete postOfficeIn;
     delete postOfficeOut;
+    delete stackPool;
     
     Exit(0);
 }
@@ -344,7 +424,10 @@ OpenFileId Kernel::Open(char *name)
 
 int Kernel::Write(char *buffer, int size, OpenFileId id)
 {
-	
+	if (id == SysConsoleOutput) {	// the display: one buffered write
+		synchConsoleOut->Write(buffer, size);
+		return size;
+	}
 	return fileSystem->Write(buffer, size * sizeof(char), id);
 }
 
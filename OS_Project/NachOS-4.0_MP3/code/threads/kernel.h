@@ -16,6 +16,9 @@
 #include "interrupt.h"
 #include "stats.h"
 #include "alarm.h"
+#include "cpu.h"
+#include "schedtrace.h"
+#include "stackpool.h"
 #include "filesys.h"
 #include "machine.h"
 
@@ -55,6 +58,9 @@ class Kernel {
 
     Thread *currentThread;	// the thread holding the CPU
     Scheduler *scheduler;	// the ready list
+    CPUSet *cpus;		// the simulated CPUs
+    SchedTrace *trace;		// the scheduler's decisions
+    StackPool *stackPool;	// free thread stacks
     Interrupt *interrupt;	// interrupt status
     Statistics *stats;		// performance metrics
     Alarm *alarm;		// the software alarm clock    
@@ -67,6 +73,7 @@ class Kernel {
     PostOfficeOutput *postOfficeOut;
 
     int hostName;               // machine identifier
+    bool profileUserProg;	// profile user programs (see profile.h)
 
   private:
 	bool priorityEnabled;
@@ -77,6 +84,17 @@ class Kernel {
 	int threadNum;
     bool randomSlice;		// enable pseudo-random time slicing
     bool debugUserProg;         // single step user program
+    bool useBlocks;		// run user programs a basic block at a time
+    int numCPUs;		// how many CPUs to simulate
+    SchedulerType schedulerType;	// which scheduling policy to use
+    TraceMode traceMode;	// how to trace the scheduler
+    char *traceFile;		// where, in binary mode
+    int quantum;		// time slice length, or 0 for adaptive
+#ifdef USE_TLB
+    int tlbEntries;		// TLB shape from -tlb, if not 0
+    int tlbWays;
+    TLBPolicy tlbPolicy;
+#endif
     double reliability;         // likelihood messages are dropped
     char *consoleIn;            // file to read console input from
     char *consoleOut;           // file to send console output to
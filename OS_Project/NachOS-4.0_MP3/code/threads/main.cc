@@ -7,7 +7,7 @@
 //              -f -cp <unix file> <nachos file>
 //              -p <nachos file> -r <nachos file> -l -D
 //              -n <network reliability> -m <machine id>
-//              -z -K -C -N
+//              -z -K -C -N -B
 //
 //    -d causes certain debugging messages to be printed (see debug.h)
 //    -rs causes Yield to occur at random (but repeatable) spots
@@ -21,6 +21,7 @@
 //    -K run a simple self test of kernel threads and synchronization
 //    -C run an interactive console test
 //    -N run a two-machine network test (see Kernel::NetworkTest)
+//    -B time the queue of pending interrupts (see LibBenchmark)
 //
 //    Filesystem-related flags:
 //    -f forces the Nachos disk to be formatted
@@ -45,6 +46,7 @@
 #include "filesys.h"
 #include "openfile.h"
 #include "sysdep.h"
+#include "libtest.h"
 
 // global variables
 Kernel *kernel;
@@ -172,6 +174,7 @@ main(int argc, char **argv)
     bool threadTestFlag = false;
     bool consoleTestFlag = false;
     bool networkTestFlag = false;
+    bool benchmarkFlag = false;
 #ifndef FILESYS_STUB
     char *copyUnixFileName = NULL;    // UNIX file to be copied into Nachos
     char *copyNachosFileName = NULL;  // name of copied file in Nachos
@@ -207,6 +210,9 @@ main(int argc, char **argv)
 	else if (strcmp(argv[i], "-N") == 0) {
 	    networkTestFlag = TRUE;
 	}
+	else if (strcmp(argv[i], "-B") == 0) {
+	    benchmarkFlag = TRUE;
+	}
 #ifndef FILESYS_STUB
 	else if (strcmp(argv[i], "-cp") == 0) {
 	    ASSERT(i + 2 < argc);
@@ -234,7 +240,7 @@ main(int argc, char **argv)
 	else if (strcmp(argv[i], "-u") == 0) {
             cout << "Partial usage: nachos [-z -d debugFlags]\n";
             cout << "Partial usage: nachos [-x programName]\n";
-	    cout << "Partial usage: nachos [-K] [-C] [-N]\n";
+	    cout << "Partial usage: nachos [-K] [-C] [-N] [-B]\n";
 #ifndef FILESYS_STUB
             cout << "Partial usage: nachos [-cp UnixFile NachosFile]\n";
             cout << "Partial usage: nachos [-p fileName] [-r fileName]\n";
@@ -264,6 +270,9 @@ main(int argc, char **argv)
     if (networkTestFlag) {
       kernel->NetworkTest();   // two-machine test of the network
     }
+    if (benchmarkFlag) {
+      LibBenchmark();   // sorted list vs. heap for pending interrupts
+    }
 
 #ifndef FILESYS_STUB
     if (removeFileName != NULL) {
@@ -0,0 +1,212 @@
+// schedtrace.cc
+//	Routines to record the scheduler's decisions, and to print them.
+//	See schedtrace.h.
+//
+//	Nothing here refers to the kernel, so that the tracedump program
+//	can print trace files with the same routines Nachos uses.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "debug.h"
+#include "sysdep.h"
+#include "schedtrace.h"
+
+//----------------------------------------------------------------------
+// SchedTrace::SchedTrace
+// 	Start tracing.
+//
+//	"traceMode" -- off, text (printed as it happens), or binary
+//	"fileName" -- UNIX file for binary events, or NULL to keep only
+//		the last TraceRingSize of them in memory
+//----------------------------------------------------------------------
+
+SchedTrace::SchedTrace(TraceMode traceMode, char *fileName)
+{
+    mode = traceMode;
+    first = count = 0;
+    fileno = -1;
+    if (fileName != NULL)
+	fileno = OpenForWrite(fileName);
+}
+
+//----------------------------------------------------------------------
+// SchedTrace::~SchedTrace
+// 	Write out the events not yet written, and close the trace file.
+//----------------------------------------------------------------------
+
+SchedTrace::~SchedTrace()
+{
+    Flush();
+    if (fileno >= 0)
+	Close(fileno);
+}
+
+//----------------------------------------------------------------------
+// SchedTrace::SetMode
+// 	Change what happens to events from now on.  Events already in the
+//	ring buffer stay there until it is flushed.
+//----------------------------------------------------------------------
+
+void
+SchedTrace::SetMode(TraceMode traceMode)
+{
+    mode = traceMode;
+}
+
+//----------------------------------------------------------------------
+// SchedTrace::Log
+// 	Record an event, while tracing is on: print it now, or put it in
+//	the ring buffer.  If the buffer is full, write it all out to the
+//	trace file first, or if there is none, drop the oldest event.
+//----------------------------------------------------------------------
+
+void
+SchedTrace::Log(int tick, int thread, int cpu, TraceEventType type,
+		int oldValue, int newValue)
+{
+    TraceEvent *event;
+
+    if (mode == TraceText) {
+	TraceEvent e;
+
+	e.tick = tick;
+	e.thread = thread;
+	e.type = type;
+	e.cpu = cpu;
+	e.oldValue = oldValue;
+	e.newValue = newValue;
+	Print(&e);
+	return;
+    }
+
+    if (count == TraceRingSize) {
+	if (fileno >= 0)
+	    Flush();
+	else {
+	    first = (first + 1) % TraceRingSize;
+	    count--;
+	}
+    }
+    event = &ring[(first + count) % TraceRingSize];
+    count++;
+    event->tick = tick;
+    event->thread = thread;
+    event->type = type;
+    event->cpu = cpu;
+    event->oldValue = oldValue;
+    event->newValue = newValue;
+}
+
+//----------------------------------------------------------------------
+// SchedTrace::Flush
+// 	Write out the events in the ring buffer, oldest first, and empty
+//	it: to the trace file, or if there is none, as text.
+//----------------------------------------------------------------------
+
+void
+SchedTrace::Flush()
+{
+    int n = min(count, TraceRingSize - first);	// up to the end of ring
+
+    if (fileno >= 0) {
+	WriteFile(fileno, (char *) &ring[first], n * sizeof(TraceEvent));
+	WriteFile(fileno, (char *) ring, (count - n) * sizeof(TraceEvent));
+    } else {
+	for (int i = 0; i < count; i++)
+	    Print(&ring[(first + i) % TraceRingSize]);
+    }
+    first = count = 0;
+}
+
+//----------------------------------------------------------------------
+// SchedTrace::Print
+// 	Print an event as text, the way the MP3 scheduler always has.
+//----------------------------------------------------------------------
+
+void
+SchedTrace::Print(TraceEvent *event)
+{
+    cout << "Tick [" << event->tick << "]: Thread [" << event->thread << "] ";
+    switch (event->type) {
+      case TraceInsert:
+	cout << "is inserted into queue L" << event->newValue << "\n";
+	break;
+      case TraceRemove:
+	cout << "is removed from queue L" << event->newValue << "\n";
+	break;
+      case TraceSelect:
+	cout << "is now selected for execution\n";
+	break;
+      case TraceReplace:
+	cout << "is replaced, and it has executed [" << event->newValue << "] ticks\n";
+	break;
+      case TracePriority:
+	cout << "changes its priority from [" << event->oldValue << "] to [" << event->newValue << "]\n";
+	break;
+      default:
+	cout << "did unknown event " << (int) event->type << "\n";
+	break;
+    }
+}
+
+//----------------------------------------------------------------------
+// SchedTrace::PrintJSON
+// 	Print an event as one or two Chrome trace events, one per line,
+//	for the "traceEvents" array: the caller prints the brackets.
+//	Each CPU is a row, and each time a thread is selected to run
+//	there, the thread that ran before ends, and the new one begins;
+//	the other events are instants.  A tick is shown as a microsecond.
+//
+//	"first" is set for the first event in the array
+//----------------------------------------------------------------------
+
+void
+SchedTrace::PrintJSON(TraceEvent *event, bool first)
+{
+    static bool running[256];	// is a thread running, on each CPU?
+    int cpu = (unsigned char) event->cpu;
+    const char *comma = first ? "" : ",\n";
+
+    if (event->type == TraceSelect) {
+	if (running[cpu]) {
+	    cout << comma << "{\"ph\":\"E\",\"pid\":0,\"tid\":" << cpu;
+	    cout << ",\"ts\":" << event->tick << "}";
+	    comma = ",\n";
+	}
+	cout << comma << "{\"name\":\"Thread " << event->thread;
+	cout << "\",\"ph\":\"B\",\"pid\":0,\"tid\":" << cpu;
+	cout << ",\"ts\":" << event->tick << "}";
+	running[cpu] = TRUE;
+	return;
+    }
+
+    cout << comma << "{\"name\":\"";
+    switch (event->type) {
+      case TraceInsert:
+	cout << "insert L" << event->newValue;
+	break;
+      case TraceRemove:
+	cout << "remove L" << event->newValue;
+	break;
+      case TraceReplace:
+	cout << "replaced";
+	break;
+      case TracePriority:
+	cout << "priority";
+	break;
+      default:
+	cout << "unknown";
+	break;
+    }
+    cout << "\",\"ph\":\"i\",\"s\":\"t\",\"pid\":0,\"tid\":" << cpu;
+    cout << ",\"ts\":" << event->tick;
+    cout << ",\"args\":{\"thread\":" << event->thread;
+    if (event->type == TraceReplace)
+	cout << ",\"ticks\":" << event->newValue;
+    else if (event->type == TracePriority)
+	cout << ",\"from\":" << event->oldValue << ",\"to\":" << event->newValue;
+    cout << "}}";
+}
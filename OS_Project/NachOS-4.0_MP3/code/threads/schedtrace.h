@@ -0,0 +1,87 @@
+// schedtrace.h
+//	Data structures for tracing the scheduler's decisions: threads
+//	put on and taken off the ready queues, context switches, and
+//	priority changes.
+//
+//	Printing each of these as it happens (the "text" mode, and the
+//	default) is slow on long runs.  Instead, the "binary" mode keeps
+//	them as fixed-size records in a ring buffer, which is written out
+//	to the trace file in one go whenever it fills up, and when Nachos
+//	halts.  The tracedump program turns a trace file back into text,
+//	or into JSON for chrome://tracing.  With tracing off, recording an
+//	event costs one test.
+//
+//	The mode can be changed at any time with SetMode.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SCHEDTRACE_H
+#define SCHEDTRACE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+// The events we trace.  oldValue and newValue mean:
+enum TraceEventType {
+    TraceInsert,	// -, the queue (1, 2 or 3 for L1, L2, L3)
+    TraceRemove,	// -, the queue
+    TraceSelect,	// -, -
+    TraceReplace,	// -, the ticks it ran for
+    TracePriority	// the old priority, the new one
+};
+
+enum TraceMode { TraceOff, TraceText, TraceBinary };
+
+// One event, as it is kept in the ring buffer and the trace file
+class TraceEvent {
+  public:
+    int tick;			// when it happened
+    short thread;		// the thread's ID
+    char type;			// a TraceEventType
+    char cpu;			// the CPU whose queue or thread it was
+    int oldValue;
+    int newValue;
+};
+
+const int TraceRingSize = 4096;	// events kept before writing them out
+
+// The following class defines the scheduler trace.
+
+class SchedTrace {
+  public:
+    SchedTrace(TraceMode traceMode, char *fileName);
+				// start tracing; in binary mode, events
+				// go to the file, or if it is NULL, only
+				// the latest ones are kept
+    ~SchedTrace();		// write out what is left
+
+    void SetMode(TraceMode traceMode);
+    TraceMode getMode() { return mode; }
+
+    void Record(int tick, int thread, int cpu, TraceEventType type,
+		int oldValue, int newValue) {
+	if (mode != TraceOff)
+	    Log(tick, thread, cpu, type, oldValue, newValue);
+    }
+    void Flush();		// write out the events in the ring
+				// buffer, oldest first
+
+    static void Print(TraceEvent *event);
+				// print an event the way MP3 does
+    static void PrintJSON(TraceEvent *event, bool first);
+				// print it for chrome://tracing
+
+  private:
+    TraceMode mode;
+    int fileno;			// UNIX file for the trace, or -1
+    TraceEvent ring[TraceRingSize];
+    int first;			// oldest event in the ring
+    int count;			// how many events are in it
+
+    void Log(int tick, int thread, int cpu, TraceEventType type,
+	     int oldValue, int newValue);
+};
+
+#endif // SCHEDTRACE_H
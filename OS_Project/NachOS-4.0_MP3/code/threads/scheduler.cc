@@ -30,28 +30,116 @@
 //----------------------------------------------------------------------
 int SJFCompare(Thread *a, Thread *b)
 {
-    if(a->getBurstTime() == b->getBurstTime())
-	return 0;
+    if(a->getBurstTime() == b->getBurstTime()) {
+	if(a->getQueueOrder() == b->getQueueOrder())
+	    return 0;
+	return (a->getQueueOrder() > b->getQueueOrder()) ? 1 : -1;
+    }
     return (a->getBurstTime() > b->getBurstTime()) ? 1 : -1;
 }
 
-int PriorityCompare(Thread *a, Thread *b)
+// Which level a thread of this priority belongs in: 0 for L1,
+// 1 for L2, 2 for L3
+static int
+LevelOf(Thread *t)
 {
-    if(a->getExecPriority() == b->getExecPriority())
+    if (t->getExecPriority() < 50)
+	return 2;
+    return (t->getExecPriority() < 100) ? 1 : 0;
+}
+
+// Return the number of the highest bit set in "word", which is not 0
+static int
+HighestBit(unsigned int word)
+{
+#ifdef __GNUC__
+    return BitsInWord - 1 - __builtin_clz(word);
+#else
+    int bit = 0;
+
+    while (word >>= 1)
+	bit++;
+    return bit;
+#endif
+}
+
+// Order threads by when they age; threads that age at the same time
+// are taken by level, as the queues used to be scanned, then by ID
+static int
+AgingCompare(Thread *a, Thread *b)
+{
+    if (a->getLastCheckInQueueTime() != b->getLastCheckInQueueTime())
+	return (a->getLastCheckInQueueTime() < b->getLastCheckInQueueTime())
+								? -1 : 1;
+    if (LevelOf(a) != LevelOf(b))
+	return (LevelOf(a) < LevelOf(b)) ? -1 : 1;
+    if (a->getID() == b->getID())
 	return 0;
-    return (a->getExecPriority() > b->getExecPriority()) ? -1 : 1;
+    return (a->getID() < b->getID()) ? -1 : 1;
 }
 
-int RoundRobinCompare(Thread *a, Thread *b)
+// Order threads by virtual runtime; threads with the same one are
+// taken first come, first served
+static int
+FairCompare(Thread *a, Thread *b)
 {
-    return -1;
+    if (a->getVruntime() != b->getVruntime())
+	return (a->getVruntime() < b->getVruntime()) ? -1 : 1;
+    if (a->getQueueOrder() == b->getQueueOrder())
+	return 0;
+    return (a->getQueueOrder() < b->getQueueOrder()) ? -1 : 1;
+}
+
+// Record a scheduling decision, at the current time; when tracing is
+// off, this is just a test
+static inline void
+Trace(TraceEventType type, Thread *thread, int cpu, int oldValue, int newValue)
+{
+    kernel->trace->Record(kernel->stats->totalTicks, thread->getID(), cpu,
+			  type, oldValue, newValue);
 }
 
-Scheduler::Scheduler()
+// Order real-time threads by deadline, then first come, first served
+static int
+DeadlineCompare(Thread *a, Thread *b)
 {
-    L[2] = new SortedList<Thread *>(RoundRobinCompare);
-    L[0] = new SortedList<Thread *>(SJFCompare);
-    L[1] = new SortedList<Thread *>(PriorityCompare);
+    if (a->getDeadline() != b->getDeadline())
+	return (a->getDeadline() < b->getDeadline()) ? -1 : 1;
+    if (a->getQueueOrder() == b->getQueueOrder())
+	return 0;
+    return (a->getQueueOrder() < b->getQueueOrder()) ? -1 : 1;
+}
+
+// Weights for the fair scheduler, from the highest priority to the
+// lowest: each is about 1.25 times the next, so a thread one step up
+// gets about 10% more of the CPU than one a step down.  (These are
+// Linux's weights for nice -20 to 19.)
+static const int fairWeights[40] = {
+    88761, 71755, 56483, 46273, 36291, 29154, 23254, 18705, 14949, 11916,
+    9548, 7620, 6100, 4904, 3906, 3121, 2501, 1991, 1586, 1277,
+    1024, 820, 655, 526, 423, 335, 272, 215, 172, 137,
+    110, 87, 70, 56, 45, 36, 29, 23, 18, 15
+};
+
+Scheduler::Scheduler(int cpu)
+{
+    L1 = new Heap<Thread *>(SJFCompare);
+    for (int i = 0; i < L2Levels; i++)
+	L2[i] = new List<Thread *>;
+    for (int i = 0; i < L2MapWords; i++)
+	L2Map[i] = 0;
+    L3 = new List<Thread *>;
+    readyList = new List<Thread *>;
+    fairQueue = new Heap<Thread *>(FairCompare);
+    minVruntime = 0;
+    realTime = new Heap<Thread *>(DeadlineCompare);
+    periods = new Heap<Thread *>(DeadlineCompare);
+    utilization = 0;
+    nextOrder = 0;
+    numReady = 0;
+    cpuNumber = cpu;
+    agingQueue = new Heap<Thread *>(AgingCompare);
+    schedulerType = MultiLevel;
   
     toBeDestroyed = NULL;
 }
@@ -63,9 +151,15 @@ Scheduler::Scheduler()
 
 Scheduler::~Scheduler()
 { 
-    delete L[0];
-    delete L[1];
-    delete L[2];
+    delete L1;
+    for (int i = 0; i < L2Levels; i++)
+	delete L2[i];
+    delete L3;
+    delete readyList;
+    delete fairQueue;
+    delete realTime;
+    delete periods;
+    delete agingQueue;
 } 
 
 //----------------------------------------------------------------------
@@ -74,33 +168,156 @@ Scheduler::~Scheduler()
 //	Put it on the ready list, for later scheduling onto the CPU.
 //
 //	"thread" is the thread to be put on the ready list.
+//
+//	A thread that last ran on another CPU goes on that CPU's ready
+//	list instead (see cpu.h).
+//
+//	With the fair scheduler, a thread that has slept keeps at most
+//	FairLatency/2 of credit over the threads that did not, and a new
+//	thread starts with none.
+//
+//	A real-time thread that has used up its budget is not put on the
+//	ready list until its next period (see Scheduler::CallBack).
 //----------------------------------------------------------------------
 
 void
 Scheduler::ReadyToRun (Thread *thread)
 {
     ASSERT(kernel->interrupt->getLevel() == IntOff);
+    if (thread->getCPU() >= 0 && thread->getCPU() != cpuNumber) {
+	CPU *home = kernel->cpus->Get(thread->getCPU());
+
+	home->remoteWakeups++;
+	home->scheduler->ReadyToRun(thread);
+	return;
+    }
+    if (OutOfBudget(thread)) {
+	DEBUG(dbgThread, "Throttling thread until its next period: " << thread->getName());
+	thread->setStatus(BLOCKED);
+	thread->setThrottled(TRUE);
+	return;
+    }
     DEBUG(dbgThread, "Putting thread on ready list: " << thread->getName());
 	//cout << "Putting thread on ready list: " << thread->getName() << endl ;
+    if (schedulerType == Fair) {
+	double least = minVruntime;
+
+	if (thread->getStatus() != JUST_CREATED)
+	    least -= FairLatency / 2;
+	thread->setVruntime(max(thread->getVruntime(), least));
+    }
     thread->setStatus(READY);
-    int priority = thread->getExecPriority();
+    thread->setReadySince(kernel->stats->totalTicks);
     thread->setLastCheckInQueueTime(kernel->stats->totalTicks); 
     if(kernel->currentThread != thread) isPreemptive = true;
  
-    cout << "Tick [" << kernel->stats->totalTicks  << "]: Thread [" << thread->getID() << "] is inserted into queue L";
-    if(priority < 50){
-	cout << "3\n";
-	L[2]->Insert(thread);
-    }else if(priority < 100){
-	cout << "2\n";
-	L[1]->Insert(thread);
-    }else{
-	cout << "1\n";
-        L[0]->Insert(thread);
-    }
+    if (Logged(thread))
+	Trace(TraceInsert, thread, cpuNumber, 0, LevelOf(thread) + 1);
+    Insert(thread);
+    if (!thread->IsRealTime())
+	agingQueue->Insert(thread);
 //    Print();
 }
 
+//----------------------------------------------------------------------
+// Scheduler::Insert
+// 	Put a thread in the ready queue for its priority: L1 in order of
+//	burst time, L2 at the back of the list for its priority, L3 at
+//	the front.  Or, for the other policies, in their one queue.
+//	Real-time threads go by deadline, whatever the policy.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Insert(Thread *thread)
+{
+    int i;
+
+    numReady++;
+    if (thread->IsRealTime()) {
+	thread->setQueueOrder(nextOrder++);
+	realTime->Insert(thread);
+	return;
+    }
+    if (schedulerType == RoundRobin) {
+	readyList->Append(thread);
+	return;
+    }
+    if (schedulerType == Fair) {
+	thread->setQueueOrder(nextOrder++);
+	fairQueue->Insert(thread);
+	return;
+    }
+    switch (LevelOf(thread)) {
+      case 0:
+	thread->setQueueOrder(nextOrder++);
+	L1->Insert(thread);
+	break;
+      case 1:
+	i = thread->getExecPriority() - L2Base;
+	L2[i]->Append(thread);
+	L2Map[i / BitsInWord] |= 1 << (i % BitsInWord);
+	break;
+      default:
+	L3->Prepend(thread);
+	break;
+    }
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Remove
+// 	Take a thread out of its ready queue.  Its priority must not have
+//	changed since Insert.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Remove(Thread *thread)
+{
+    int i;
+
+    numReady--;
+    if (thread->IsRealTime()) {
+	realTime->Remove(thread);
+	return;
+    }
+    if (schedulerType == RoundRobin) {
+	readyList->Remove(thread);
+	return;
+    }
+    if (schedulerType == Fair) {
+	fairQueue->Remove(thread);
+	return;
+    }
+    switch (LevelOf(thread)) {
+      case 0:
+	L1->Remove(thread);
+	break;
+      case 1:
+	i = thread->getExecPriority() - L2Base;
+	L2[i]->Remove(thread);
+	if (L2[i]->IsEmpty())
+	    L2Map[i / BitsInWord] &= ~(1 << (i % BitsInWord));
+	break;
+      default:
+	L3->Remove(thread);
+	break;
+    }
+}
+
+//----------------------------------------------------------------------
+// Scheduler::HighestL2
+// 	Return the index in L2 of the highest priority with a ready
+//	thread, or -1 if L2 is empty.
+//----------------------------------------------------------------------
+
+int
+Scheduler::HighestL2()
+{
+    for (int w = L2MapWords - 1; w >= 0; w--)
+	if (L2Map[w] != 0)
+	    return w * BitsInWord + HighestBit(L2Map[w]);
+    return -1;
+}
+
 //----------------------------------------------------------------------
 // Scheduler::FindNextToRun
 // 	Return the next thread to be scheduled onto the CPU.
@@ -112,38 +329,245 @@ Scheduler::ReadyToRun (Thread *thread)
 Thread *
 Scheduler::FindNextToRun ()
 {    
-    ASSERT(kernel->interrupt->getLevel() == IntOff);
-    if (L[0]->IsEmpty() && L[1]->IsEmpty() && L[2]->IsEmpty()) {
+    Thread *thread = FindNext();
+
+    if (thread == NULL)
 	return NULL;
-    }else if(L[1]->IsEmpty() && L[0]->IsEmpty()){
-        cout << "Tick [" << kernel->stats->totalTicks << "]: Thread [";
-	cout << L[2]->Front()->getID() << "] is removed from queue L3\n";
-	return L[2]->RemoveFront();
-    }else if(L[0]->IsEmpty()){
-        cout << "Tick [" << kernel->stats->totalTicks << "]: Thread [";
-        cout << L[1]->Front()->getID() << "] is removed from queue L2\n";
-        return L[1]->RemoveFront();
-    } else {
-        cout << "Tick [" << kernel->stats->totalTicks << "]: Thread [";
-	cout << L[0]->Front()->getID() << "] is removed from queue L1\n";
-    	return L[0]->RemoveFront();
+    if (Logged(thread))
+	Trace(TraceRemove, thread, cpuNumber, 0, LevelOf(thread) + 1);
+    Remove(thread);
+    agingQueue->Remove(thread);
+    Migrate(thread);
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Migrate
+// 	"thread" is about to run on this CPU.  If it last ran on another
+//	one, charge the time it takes to refill its cache (see
+//	CPUSet::MigrationTicks), and make this CPU its own.
+//
+//	This is done as it is taken off the ready list, before a thread
+//	that yields to it is put back on: that thread is then queued, and
+//	its aging time set, at the time the switch happens.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Migrate(Thread *thread)
+{
+    if (thread->getCPU() == cpuNumber)
+	return;
+    if (thread->getCPU() >= 0) {	// it last ran on another CPU
+	int cost = kernel->cpus->MigrationTicks(thread);
+
+	kernel->cpus->Get(cpuNumber)->migrations++;
+	kernel->stats->numMigrations++;
+	kernel->stats->migrationTicks += cost;
+	kernel->stats->totalTicks += cost;	// refilling its cache
+	kernel->stats->systemTicks += cost;
     }
+    thread->setCPU(cpuNumber);
 }
 
+//----------------------------------------------------------------------
+// Scheduler::FindNext
+// 	Return the thread FindNextToRun would, without removing it.
+//----------------------------------------------------------------------
+
 Thread*
 Scheduler::FindNext()
 {
+    int i;
+
     ASSERT(kernel->interrupt->getLevel() == IntOff);
-    if (L[0]->IsEmpty() && L[1]->IsEmpty() && L[2]->IsEmpty()) {
-        return NULL;
-    }else if(L[1]->IsEmpty() && L[0]->IsEmpty()){
-        return L[2]->Front();
-    }else if(L[0]->IsEmpty()){
-        return L[1]->Front();
+    if (!realTime->IsEmpty())
+	return realTime->Front();
+    if (schedulerType == RoundRobin)
+	return readyList->IsEmpty() ? NULL : readyList->Front();
+    if (schedulerType == Fair)
+	return fairQueue->IsEmpty() ? NULL : fairQueue->Front();
+    if (!L1->IsEmpty())
+	return L1->Front();
+    if ((i = HighestL2()) >= 0)
+	return L2[i]->Front();
+    if (!L3->IsEmpty())
+	return L3->Front();
+    return NULL;
+}
+//----------------------------------------------------------------------
+// NoteLast, NoteLongest
+// 	Called through List/Heap::Apply, to find the ready thread that
+//	RemoveLast should take: the last one in a list, or the largest in
+//	a heap (the longest burst in L1, or the most vruntime), that may
+//	move to another CPU.
+//----------------------------------------------------------------------
+
+static Thread *lastFound;	// what we have found so far
+static Thread *keepThread;	// a thread that must not move
+static bool onlyCold;		// skip threads whose caches are warm?
+static int (*heapCompare)(Thread *a, Thread *b);
+				// how the heap is ordered
+
+static bool
+Movable(Thread *t)
+{
+    return t != keepThread
+		&& (!onlyCold || kernel->cpus->MigrationTicks(t) == 0);
+}
+
+static void
+NoteLast(Thread *t)
+{
+    if (Movable(t))
+	lastFound = t;
+}
+
+static void
+NoteLongest(Thread *t)
+{
+    if (Movable(t) && (lastFound == NULL || heapCompare(t, lastFound) > 0))
+	lastFound = t;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::RemoveLast
+// 	Take the ready thread that this CPU would run last off the ready
+//	list, and return it, so another CPU can run it.  Like the thief's
+//	end of a work-stealing deque, this leaves alone the threads this
+//	CPU is about to run.  Real-time threads are never taken: they
+//	were admitted on this CPU.  Returns NULL if there is none.
+//
+//	"keep" is a thread that must stay here, or NULL
+//	"coldOnly" is set to skip threads that ran here recently, whose
+//		caches would be lost if they moved
+//----------------------------------------------------------------------
+
+Thread *
+Scheduler::RemoveLast(Thread *keep, bool coldOnly)
+{
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+    lastFound = NULL;
+    keepThread = keep;
+    onlyCold = coldOnly;
+    if (schedulerType == RoundRobin) {
+	readyList->Apply(NoteLast);
+    } else if (schedulerType == Fair) {
+	heapCompare = FairCompare;
+	fairQueue->Apply(NoteLongest);
     } else {
-        return L[0]->Front();
+	L3->Apply(NoteLast);
+	for (int i = 0; i < L2Levels && lastFound == NULL; i++)
+	    L2[i]->Apply(NoteLast);
+	heapCompare = SJFCompare;
+	if (lastFound == NULL)
+	    L1->Apply(NoteLongest);
+    }
+    if (lastFound == NULL)
+	return NULL;
+
+    if (Logged(lastFound))
+	Trace(TraceRemove, lastFound, cpuNumber, 0, LevelOf(lastFound) + 1);
+    Remove(lastFound);
+    agingQueue->Remove(lastFound);
+    return lastFound;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Adopt
+// 	Put a thread that RemoveLast took from another CPU on this CPU's
+//	ready list.  Unlike ReadyToRun, it keeps the time it has already
+//	waited towards aging.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Adopt(Thread *thread)
+{
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+    ASSERT(thread->getStatus() == READY);
+    if (Logged(thread))
+	Trace(TraceInsert, thread, cpuNumber, 0, LevelOf(thread) + 1);
+    Insert(thread);
+    agingQueue->Insert(thread);		// never a real-time thread
+}
+
+//----------------------------------------------------------------------
+// Scheduler::NextAgingTime
+// 	Return the time at which the next ready thread will have waited
+//	AgingTicks.  If no thread is ready, none can age before AgingTicks
+//	from now.  Only the multi-level queue ages threads.
+//----------------------------------------------------------------------
+
+int
+Scheduler::NextAgingTime()
+{
+    if (agingQueue->IsEmpty() || schedulerType != MultiLevel)
+	return kernel->stats->totalTicks + AgingTicks;
+    return agingQueue->Front()->getLastCheckInQueueTime() + AgingTicks;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Age
+// 	Raise the priority of every ready thread that has waited in its
+//	queue for AgingTicks since it was put there, or last aged.
+//	Called on every clock tick, so the common case -- nobody is due
+//	-- only looks at the front of agingQueue.
+//
+//	Threads due together are aged L1 first, then L2, then L3, so
+//	one promoted to the next level up is not aged twice.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Age()
+{
+    int now = kernel->stats->totalTicks;
+    List<Thread *> due;
+
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+    if (schedulerType != MultiLevel || NextAgingTime() > now)
+	return;
+    while (!agingQueue->IsEmpty() && NextAgingTime() <= now)
+	due.Append(agingQueue->RemoveFront());
+
+    for (int level = 0; level < 3; level++) {
+	ListIterator<Thread *> it(&due);
+
+	for (; !it.IsDone(); it.Next())
+	    if (LevelOf(it.Item()) == level)
+		AgeThread(it.Item(), level);
     }
+    while (!due.IsEmpty())
+	agingQueue->Insert(due.RemoveFront());
 }
+
+//----------------------------------------------------------------------
+// Scheduler::AgeThread
+// 	Raise the priority of "thread" by 10, and move it up to the next
+//	level if it has reached it: L3 at 50, L2 at 100.  In L1 the
+//	priority stops at 149.
+//
+//	"thread" is the thread to age, taken out of agingQueue
+//	"level" is its level: 0 for L1, 1 for L2, 2 for L3
+//----------------------------------------------------------------------
+
+void
+Scheduler::AgeThread(Thread *thread, int level)
+{
+    int now = kernel->stats->totalTicks;
+    int priority = thread->getExecPriority() + 10;
+
+    if (level == 0)
+	priority = min(priority, 149);
+    Trace(TracePriority, thread, cpuNumber, thread->getExecPriority(), priority);
+    Remove(thread);
+    thread->setExecPriority(priority);
+    thread->setLastCheckInQueueTime(now);
+    Insert(thread);
+    if (LevelOf(thread) < level) {
+	Trace(TraceRemove, thread, cpuNumber, 0, level + 1);
+	Trace(TraceInsert, thread, cpuNumber, 0, level);
+    }
+}
+
 //----------------------------------------------------------------------
 // Scheduler::Run
 // 	Dispatch the CPU to nextThread.  Save the state of the old thread,
@@ -164,6 +588,7 @@ void
 Scheduler::Run (Thread *nextThread, bool finishing)
 {
     Thread *oldThread = kernel->currentThread;
+    int waited;			// how long nextThread was ready
     
     ASSERT(kernel->interrupt->getLevel() == IntOff);
 
@@ -182,8 +607,14 @@ Scheduler::Run (Thread *nextThread, bool finishing)
 
     kernel->currentThread = nextThread;  // switch to the next thread
     nextThread->setStatus(RUNNING);      // nextThread is now running
+    waited = max(kernel->stats->totalTicks - nextThread->getReadySince(), 0);
+    nextThread->addReadyTicks(waited);
+    kernel->stats->numContextSwitches++;
+    kernel->stats->responseTicks += waited;
+    if (schedulerType == Fair)
+	minVruntime = max(minVruntime, nextThread->getVruntime());
    
-    oldThread->setLastCheckInQueueTime(kernel->stats->totalTicks);
+    oldThread->setLastRan(kernel->stats->totalTicks);
 
     kernel->currentThread->setExecTime(0);
     DEBUG(dbgThread, "Switching from: " << oldThread->getName() << " to: " << nextThread->getName());
@@ -192,20 +623,13 @@ Scheduler::Run (Thread *nextThread, bool finishing)
     // in switch.s.  You may have to think
     // a bit to figure out what happens after this, both from the point
     // of view of the thread and from the perspective of the "outside world".
-    cout << "Tick [" << kernel->stats->totalTicks  << "]: Thread [" << nextThread->getID() << "] is now selected for execution\n";
-
-    cout << "Tick [" << kernel->stats->totalTicks  << "]: Thread [" << oldThread->getID() << "] is replaced, and it has executed [";
-
-    cout << oldThread->getExecTime() << "] ticks\n";
-    if(nextThread->getExecPriority() < 50)
-	kernel->alarm->SetActive(TRUE);
-    else
-	kernel->alarm->SetActive(FALSE);
+    Trace(TraceSelect, nextThread, cpuNumber, 0, 0);
+    Trace(TraceReplace, oldThread, cpuNumber, 0, oldThread->getExecTime());
+    kernel->alarm->SetActive(TimeSliced(nextThread));
+    kernel->alarm->StartSlice(nextThread);
 	
     SWITCH(oldThread, nextThread);
 
-
-    oldThread->setBurstTime(oldThread->getBurstTime()/2 + oldThread->getExecTime()/2);    
     // we're back, running oldThread
       
     // interrupts are off when we return from switch!
@@ -213,9 +637,11 @@ Scheduler::Run (Thread *nextThread, bool finishing)
 
     DEBUG(dbgThread, "Now in thread: " << oldThread->getName());
 
-    CheckToBeDestroyed();		// check if thread we were running
+    kernel->scheduler->CheckToBeDestroyed();
+					// check if thread we were running
 					// before this one has finished
 					// and needs to be cleaned up
+					// (on whichever CPU we are now)
     
     if (oldThread->space != NULL) {	    // if there is an address space
         oldThread->RestoreUserState();     // to restore, do it.
@@ -223,6 +649,221 @@ Scheduler::Run (Thread *nextThread, bool finishing)
     }
 }
 
+//----------------------------------------------------------------------
+// Scheduler::Charge
+// 	Account for "ticks" of time that "thread" has just run: with the
+//	fair scheduler, its virtual runtime grows by them, scaled down by
+//	its weight.  A real-time thread's budget shrinks by them.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Charge(Thread *thread, int ticks)
+{
+    thread->addCPUTicks(ticks);
+    if (thread->IsRealTime())
+	thread->setBudgetLeft(thread->getBudgetLeft() - ticks);
+    if (schedulerType == Fair)
+	thread->setVruntime(thread->getVruntime()
+			+ (double) ticks * NiceZeroWeight / Weight(thread));
+}
+
+//----------------------------------------------------------------------
+// Scheduler::NeedPreempt
+// 	Return TRUE if "thread", the one running, should give up the CPU:
+//	if it is a real-time thread that has used up its budget, or the
+//	first ready thread should take the CPU from it.  A real-time
+//	thread with an earlier deadline takes it from any other thread.
+//
+//	Otherwise, this decides for round robin and fair scheduling only.
+//	(Interrupt::NeedPreempt decides for the multi-level queue.)
+//	Round robin only switches threads on timer interrupts; the fair
+//	scheduler does once the running thread's vruntime is
+//	FairGranularity ahead.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::NeedPreempt(Thread *thread)
+{
+    Thread *next = FindNext();
+
+    if (OutOfBudget(thread))
+	return TRUE;
+    if (next != NULL && next->IsRealTime())
+	return !thread->IsRealTime()
+			|| next->getDeadline() < thread->getDeadline();
+    if (thread->IsRealTime())
+	return FALSE;
+    ASSERT(schedulerType != MultiLevel);
+    if (schedulerType == RoundRobin || next == NULL)
+	return FALSE;
+    return next->getVruntime() + FairGranularity < thread->getVruntime();
+}
+
+//----------------------------------------------------------------------
+// Scheduler::TicksUntilPreempt
+// 	Return how many ticks "thread", the one running, can be charged
+//	before NeedPreempt first returns TRUE for it, if no other thread
+//	becomes ready meanwhile; -1 if that will not happen.  Only the
+//	fair scheduler preempts a thread just for running: once its
+//	vruntime, which grows by NiceZeroWeight / Weight per tick, is
+//	more than FairGranularity ahead of the first ready thread's.
+//
+//	Called with NeedPreempt already FALSE.
+//----------------------------------------------------------------------
+
+int
+Scheduler::TicksUntilPreempt(Thread *thread)
+{
+    Thread *next = FindNext();
+    double ticks;
+    int whole;
+
+    if (schedulerType != Fair || next == NULL || thread->IsRealTime()
+	    || next->IsRealTime())
+	return -1;
+    ticks = (next->getVruntime() + FairGranularity - thread->getVruntime())
+		* Weight(thread) / NiceZeroWeight;
+    whole = (int) ticks;		// rounded up
+    if (whole < ticks)
+	whole++;
+    return max(0, whole);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::TimeSliced
+// 	Return TRUE if "thread", when it runs, should yield the CPU on
+//	every timer interrupt: only in L3, for the multi-level queue;
+//	always, for round robin; never, for the fair scheduler, which
+//	preempts by vruntime instead, or for real-time threads.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::TimeSliced(Thread *thread)
+{
+    if (thread->IsRealTime())
+	return FALSE;
+    if (schedulerType == MultiLevel)
+	return thread->getExecPriority() < 50;
+    return schedulerType == RoundRobin;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Weight
+// 	Return the share of the CPU "thread" gets under the fair
+//	scheduler, for its priority: NiceZeroWeight for priorities 72
+//	to 74, about 86 times that for 149, and 1/68 of it for 0.
+//----------------------------------------------------------------------
+
+int
+Scheduler::Weight(Thread *thread)
+{
+    int priority = max(0, min(thread->getExecPriority(), 149));
+
+    return fairWeights[39 - priority * 40 / 150];
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Admit
+// 	Make "thread", which is running on this CPU, a real-time thread:
+//	from now on it may run "budget" ticks in every "period" ticks,
+//	ahead of any other thread whose deadline (the end of its current
+//	period) is later.  It stays on this CPU.
+//
+//	Returns FALSE, and leaves the thread as it was, if the arguments
+//	make no sense, or if the real-time threads already on this CPU
+//	would then need more than all of it: EDF can meet every deadline
+//	as long as the sum of budget/period is at most 1.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::Admit(Thread *thread, int period, int budget)
+{
+    int now = kernel->stats->totalTicks;
+    double needed = utilization;
+
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+    ASSERT(thread == kernel->currentThread);
+    if (period <= 0 || budget <= 0 || budget > period)
+	return FALSE;
+    if (thread->IsRealTime())		// just changing its reservation
+	needed -= (double) thread->getBudget() / thread->getPeriod();
+    if (needed + (double) budget / period > 1.0) {
+	DEBUG(dbgThread, "Rejecting real-time thread " << thread->getName() << ": utilization " << needed << " + " << budget << "/" << period);
+	return FALSE;
+    }
+
+    if (thread->IsRealTime())
+	periods->Remove(thread);
+    utilization = needed + (double) budget / period;
+    thread->setPeriod(period, budget);
+    thread->setBudgetLeft(budget);
+    thread->setDeadline(now + period);
+    periods->Insert(thread);
+    kernel->interrupt->Schedule(this, period, TimerInt);
+    DEBUG(dbgThread, "Admitting real-time thread " << thread->getName() << ": " << budget << " ticks every " << period << ", utilization " << utilization);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Release
+// 	"thread", a real-time thread, is finishing: give back its share of
+//	the CPU.  The interrupt for the end of its period will find it
+//	gone, and do nothing.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Release(Thread *thread)
+{
+    ASSERT(thread->IsRealTime());
+    periods->Remove(thread);
+    utilization -= (double) thread->getBudget() / thread->getPeriod();
+    thread->setPeriod(0, 0);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::CallBack
+// 	Interrupt handler for the end of a real-time thread's period: we
+//	scheduled one at each thread's deadline.  For every thread whose
+//	period is over, start the next one: refill its budget, move its
+//	deadline on, and let it run again if it was throttled.
+//
+//	A thread that still wanted to run -- ready, or running, with
+//	budget left -- has missed its deadline.
+//----------------------------------------------------------------------
+
+void
+Scheduler::CallBack()
+{
+    Statistics *stats = kernel->stats;
+    int now = stats->totalTicks;
+
+    while (!periods->IsEmpty() && periods->Front()->getDeadline() <= now) {
+	Thread *thread = periods->RemoveFront();
+	bool ready = (thread->getStatus() == READY);
+
+	stats->numPeriods++;
+	if (thread->getBudgetLeft() > 0
+		&& (ready || thread->getStatus() == RUNNING)) {
+	    DEBUG(dbgThread, "Thread " << thread->getName() << " missed its deadline at " << thread->getDeadline());
+	    stats->numDeadlineMisses++;
+	}
+	if (ready)			// its place in realTime changes
+	    Remove(thread);
+	thread->setBudgetLeft(thread->getBudget());
+	thread->setDeadline(thread->getDeadline() + thread->getPeriod());
+	if (ready)
+	    Insert(thread);
+	periods->Insert(thread);
+	if (thread->getDeadline() > now)
+	    kernel->interrupt->Schedule(this, thread->getDeadline() - now,
+								TimerInt);
+	if (thread->isThrottled()) {
+	    thread->setThrottled(FALSE);
+	    ReadyToRun(thread);
+	}
+    }
+}
+
 //----------------------------------------------------------------------
 // Scheduler::CheckToBeDestroyed
 // 	If the old thread gave up the processor because it was finishing,
@@ -250,9 +891,10 @@ Scheduler::Print()
 {
     cout << "Ready list contents:\n";
     cout << "L1:\n";
-    L[0]->Apply(ThreadPrint);
+    L1->Apply(ThreadPrint);
     cout << "\nL2:\n";
-    L[1]->Apply(ThreadPrint);
+    for (int i = L2Levels - 1; i >= 0; i--)
+	L2[i]->Apply(ThreadPrint);
     cout << "\nL3:\n";
-    L[2]->Apply(ThreadPrint);
+    L3->Apply(ThreadPrint);
 }
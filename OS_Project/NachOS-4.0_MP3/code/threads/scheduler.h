@@ -11,21 +11,58 @@
 
 #include "copyright.h"
 #include "list.h"
+#include "heap.h"
+#include "bitmap.h"
+#include "callback.h"
 #include "thread.h"
 
 // The following class defines the scheduler/dispatcher abstraction -- 
 // the data structures and operations needed to keep track of which 
 // thread is running, and which threads are ready but not running.
+//
+// Ready threads are kept in three levels, by priority:
+//	L1 (100-149) -- shortest (predicted) burst first, in a heap
+//	L2 (50-99)   -- highest priority first: one FIFO per priority,
+//			and a bitmap of which ones are not empty
+//	L3 (0-49)    -- one list, regardless of priority
+// so that putting a thread on the ready list and finding the next
+// one to run take constant (L2, L3) or logarithmic (L1) time.
+//
+// That is the multi-level feedback queue, the default.  Booting with
+// "-sched rr" or "-sched cfs" picks one of the other policies:
+//	RoundRobin -- one FIFO list, every thread time-sliced
+//	Fair	   -- least virtual runtime first, in a heap; a thread's
+//		      virtual runtime grows more slowly the higher its
+//		      priority (see Scheduler::Weight)
+//
+// Under any policy, real-time threads -- those that asked to run
+// "budget" ticks every "period" (see Scheduler::Admit) -- are kept in
+// a heap of their own, earliest deadline first, and run before any
+// other thread.  One that has used up its budget waits for its next
+// period.  The scheduler is called back at the end of each period.
+
+const int L2Base = 50;			// lowest priority in L2
+const int L2Levels = 50;		// number of priorities in L2
+const int L2MapWords = divRoundUp(L2Levels, BitsInWord);
+
 enum SchedulerType{
+    MultiLevel,
     RoundRobin,
-    SJF,
-    Priority
+    Fair
 };
 
+const int NiceZeroWeight = 1024;	// weight of a middling priority
+const int FairGranularity = 100;	// how far behind the current
+					// thread another must be to
+					// preempt it, in weighted ticks
+const int FairLatency = 1000;		// how much credit a thread that
+					// slept keeps, in weighted ticks
+
 
-class Scheduler {
+class Scheduler : public CallBackObj {
   public:
-    Scheduler();		// Initialize list of ready threads 
+    Scheduler(int cpu = 0);	// Initialize list of ready threads,
+				// for CPU number "cpu"
     ~Scheduler();		// De-allocate ready list
 
     void ReadyToRun(Thread* thread);
@@ -38,20 +75,74 @@ class Scheduler {
     void CheckToBeDestroyed();// Check if thread that had been
     				// running needs to be deleted
     void Print();		// Print contents of ready list
-    SortedList<Thread *>* getQueue(int index){return L[index];} 
+    void Age();			// Raise the priority of threads that
+				// have waited AgingTicks
+    int NextAgingTime();	// When the next thread will need it
+    int NumReady() { return numReady; }
+    Thread *RemoveLast(Thread *keep, bool coldOnly);
+				// Take the thread that would run last
+				// off the ready list, for another CPU
+    void Adopt(Thread *thread);	// Put a thread taken from another
+				// CPU's ready list on this one
     SchedulerType getSchedulerType() {return schedulerType;}
-    void setSchedulerType(SchedulerType t){schedulerType = t;} 
+    void setSchedulerType(SchedulerType t){
+	ASSERT(numReady == 0); schedulerType = t;}
+    void Charge(Thread *thread, int ticks);
+				// Account for time a thread ran
+    bool NeedPreempt(Thread *thread);
+				// Should the first ready thread take
+				// the CPU from this one?
+    int TicksUntilPreempt(Thread *thread);
+				// How long until it should, if this one
+				// just keeps running; -1 if never
+    bool TimeSliced(Thread *thread);
+				// Does this one give up the CPU on
+				// every timer interrupt?
+    static int Weight(Thread *thread);
+				// Its share of the CPU, for its priority
+    bool Admit(Thread *thread, int period, int budget);
+				// Make a thread real-time, if there is
+				// room for it
+    void Release(Thread *thread);
+				// Real-time thread is finishing
+    bool OutOfBudget(Thread *thread) {
+	return thread->IsRealTime() && thread->getBudgetLeft() <= 0; }
+    int NumMovable() { return numReady - realTime->NumInHeap(); }
+				// ready threads that may go to another
+				// CPU: not real-time ones
+    void CallBack();		// some real-time thread's period is over
     // SelfTest for scheduler is implemented in class Thread
     bool isPreemptive;
     
   private:
- //   List<Thread *> *readyList;  // queue of threads that are ready to run,
-				// but not running
-    //List<Thread *> *L[3];
-    SortedList<Thread *> *L[3];
+    Heap<Thread *> *L1;		// by burst time, then queueOrder
+    List<Thread *> *L2[L2Levels];	// L2[p - L2Base] for priority p
+    unsigned int L2Map[L2MapWords];	// bit i set if L2[i] is not empty
+    List<Thread *> *L3;		// newest first
+    List<Thread *> *readyList;	// RoundRobin: first come, first served
+    Heap<Thread *> *fairQueue;	// Fair: by vruntime, then queueOrder
+    double minVruntime;		// Fair: vruntime of the last thread run
+    Heap<Thread *> *realTime;	// ready real-time threads, by deadline
+    Heap<Thread *> *periods;	// all of them, by deadline
+    double utilization;		// sum of their budget/period
+    unsigned int nextOrder;	// queueOrder for the next thread in L1
+    int numReady;		// threads in L1, L2 and L3
+    int cpuNumber;		// the CPU whose threads these are
+    Heap<Thread *> *agingQueue;	// the ready threads, by when they age
     SchedulerType schedulerType;
     Thread *toBeDestroyed;	// finishing thread to be destroyed
     				// by the next thread that runs
+
+    void Insert(Thread *thread);	// put thread in its level
+    void Remove(Thread *thread);	// take it out again
+    void Migrate(Thread *thread);	// it is about to run here
+    int HighestL2();		// index of the first non-empty L2 list,
+				// or -1
+    bool Logged(Thread *thread) {
+	return schedulerType == MultiLevel && !thread->IsRealTime(); }
+				// print its moves between L1, L2, L3?
+    void AgeThread(Thread *thread, int level);
+    				// Age one thread, now in level+1
 };
 
 #endif // SCHEDULER_H
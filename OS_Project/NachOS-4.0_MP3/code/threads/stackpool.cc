@@ -0,0 +1,112 @@
+// stackpool.cc
+//	Routines to hand out thread execution stacks, and to take them
+//	back for the next thread.  See stackpool.h.
+//
+//	A free stack is not used for anything else, so the list of free
+//	stacks is kept in the stacks themselves.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "debug.h"
+#include "sysdep.h"
+#include "thread.h"
+#include "stackpool.h"
+
+//----------------------------------------------------------------------
+// StackPool::StackPool
+// 	Initialize an empty pool.
+//----------------------------------------------------------------------
+
+StackPool::StackPool()
+{
+    for (int i = 0; i < 2; i++) {
+	freeStacks[i] = NULL;
+	numFree[i] = 0;
+    }
+    allocated = reused = 0;
+}
+
+//----------------------------------------------------------------------
+// StackPool::~StackPool
+// 	De-allocate the free stacks.  Stacks still in use belong to
+//	threads that were never deleted.
+//----------------------------------------------------------------------
+
+StackPool::~StackPool()
+{
+    int size[2] = { StackSize, SmallStackSize };
+
+    DEBUG(dbgThread, "Stacks allocated: " << allocated << ", reused: " << reused);
+    for (int i = 0; i < 2; i++) {
+	while (freeStacks[i] != NULL) {
+	    int *stack = freeStacks[i];
+
+	    freeStacks[i] = *(int **) stack;
+	    DeallocBoundedArray((char *) stack, size[i] * sizeof(int));
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// StackPool::Which
+// 	Return which list holds stacks of the given size.
+//
+//	"size" -- StackSize or SmallStackSize, in words
+//----------------------------------------------------------------------
+
+int
+StackPool::Which(int size)
+{
+    ASSERT(size == StackSize || size == SmallStackSize);
+    return (size == StackSize) ? 0 : 1;
+}
+
+//----------------------------------------------------------------------
+// StackPool::Get
+// 	Return a stack, with its guard pages: a free one if there is
+//	one, otherwise a new one.
+//
+//	"size" -- how big a stack, in words
+//----------------------------------------------------------------------
+
+int *
+StackPool::Get(int size)
+{
+    int i = Which(size);
+    int *stack = freeStacks[i];
+
+    if (stack == NULL) {
+	allocated++;
+	return (int *) AllocBoundedArray(size * sizeof(int));
+    }
+    freeStacks[i] = *(int **) stack;
+    numFree[i]--;
+    reused++;
+    return stack;
+}
+
+//----------------------------------------------------------------------
+// StackPool::Put
+// 	Keep a stack that is no longer used, for the next thread.  If
+//	there are already enough free ones, de-allocate it instead.
+//
+//	"stack" -- the stack, as returned by Get
+//	"size" -- its size, in words
+//----------------------------------------------------------------------
+
+void
+StackPool::Put(int *stack, int size)
+{
+    int i = Which(size);
+
+    if (numFree[i] == MaxFreeStacks) {
+	DeallocBoundedArray((char *) stack, size * sizeof(int));
+	return;
+    }
+    *(int **) stack = freeStacks[i];
+    freeStacks[i] = stack;
+    numFree[i]++;
+}
@@ -0,0 +1,52 @@
+// stackpool.h
+//	Data structures to recycle thread execution stacks.
+//
+//	Each stack is allocated with AllocBoundedArray, which unmaps the
+//	pages on either side of it to catch overflows; that takes two
+//	mprotect system calls, and two more to undo it.  Programs that
+//	fork many short-lived threads would spend most of their time
+//	there.  Instead, when a thread is deleted, its stack is kept
+//	here, guard pages and all, for the next thread that needs a
+//	stack of that size.  Once enough stacks have been freed, forking
+//	and deleting threads no longer allocates stacks at all.
+//
+//	Stacks come in two sizes: the usual StackSize, and SmallStackSize
+//	for kernel helper threads that never call very deep.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef STACKPOOL_H
+#define STACKPOOL_H
+
+#include "copyright.h"
+#include "utility.h"
+
+const int SmallStackSize = (2 * 1024);	// in words, for helper threads
+const int MaxFreeStacks = 32;	// free stacks kept, of each size;
+				// any more are given back
+
+// The following class defines the pool of free stacks.
+
+class StackPool {
+  public:
+    StackPool();		// start with no free stacks
+    ~StackPool();		// de-allocate the free stacks
+
+    int *Get(int size);		// a stack of "size" words, from the pool
+				// if there is one free
+    void Put(int *stack, int size);
+				// the stack is no longer used
+
+  private:
+    int *freeStacks[2];		// the free stacks of each size, linked
+				// through their first word
+    int numFree[2];		// how many are on each list
+    int allocated;		// stacks allocated so far
+    int reused;			// stacks handed out again
+
+    int Which(int size);	// which list has stacks of this size
+};
+
+#endif // STACKPOOL_H
@@ -118,6 +118,7 @@ void
 SynchList<T>::SelfTest(T val)
 {
     Thread *helper = new Thread("ping", 1);
+    helper->setStackSize(SmallStackSize);	// it does very little
     
     ASSERT(list->IsEmpty());
     selfTestPing = new SynchList<T>;
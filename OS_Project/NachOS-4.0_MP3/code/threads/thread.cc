@@ -39,6 +39,7 @@ Thread::Thread(char* threadName, int threadID)
     name = threadName;
     stackTop = NULL;
     stack = NULL;
+    stackSize = StackSize;
     status = JUST_CREATED;
     for (int i = 0; i < MachineStateSize; i++) {
 	machineState[i] = NULL;		// not strictly necessary, since
@@ -47,6 +48,16 @@ Thread::Thread(char* threadName, int threadID)
     }
     execTime = 0;
     lastCheckInQueueTime = 0;
+    queueOrder = 0;
+    cpu = -1;
+    lastRan = 0;
+    vruntime = 0;
+    readySince = 0;
+    cpuTicks = readyTicks = 0;
+    period = budget = budgetLeft = deadline = 0;
+    throttled = FALSE;
+    wakeTime = 0;
+    wakeOrder = 0;
     burstTime = 0;
     execPriority = 0;
     space = NULL;
@@ -58,11 +69,22 @@ Thread::Thread(char* threadName, int threadID, int priority)
     name = threadName;
     stackTop = NULL;
     stack = NULL;
+    stackSize = StackSize;
     status = JUST_CREATED;
     for(int i = 0; i < MachineStateSize; i++)
 	machineState[i] = NULL;
     execTime = 0;
     lastCheckInQueueTime = 0;
+    queueOrder = 0;
+    cpu = -1;
+    lastRan = 0;
+    vruntime = 0;
+    readySince = 0;
+    cpuTicks = readyTicks = 0;
+    period = budget = budgetLeft = deadline = 0;
+    throttled = FALSE;
+    wakeTime = 0;
+    wakeOrder = 0;
     execPriority = priority;
     burstTime = 0;
     space = NULL;
@@ -85,7 +107,7 @@ Thread::~Thread()
     DEBUG(dbgThread, "Deleting thread: " << name);
     ASSERT(this != kernel->currentThread);
     if (stack != NULL)
-	DeallocBoundedArray((char *) stack, StackSize * sizeof(int));
+	kernel->stackPool->Put(stack, stackSize);	// for the next thread
 }
 
 //----------------------------------------------------------------------
@@ -144,7 +166,7 @@ Thread::CheckOverflow()
 {
     if (stack != NULL) {
 #ifdef HPUX			// Stacks grow upward on the Snakes
-	ASSERT(stack[StackSize - 1] == STACK_FENCEPOST);
+	ASSERT(stack[stackSize - 1] == STACK_FENCEPOST);
 #else
 	ASSERT(*stack == STACK_FENCEPOST);
 #endif
@@ -194,11 +216,40 @@ Thread::Finish ()
     ASSERT(this == kernel->currentThread);
     
     DEBUG(dbgThread, "Finishing thread: " << name);
+    if (ID >= 0 && cpuTicks + readyTicks > 0) {
+	Statistics *stats = kernel->stats;	// how much of the time it
+	double share = (double) cpuTicks	// could have run, it did,
+		/ (cpuTicks + readyTicks)	// for its weight
+		/ Scheduler::Weight(this);
+
+	stats->numFairThreads++;
+	stats->fairShareSum += share;
+	stats->fairShareSquares += share * share;
+    }
+    if (IsRealTime())
+	kernel->scheduler->Release(this);
     Sleep(TRUE);				// invokes SWITCH
     // not reached
 }
 
 
+//----------------------------------------------------------------------
+// Thread::EndBurst
+// 	The thread is giving up the CPU: update the prediction of its
+//	next CPU burst, which orders L1 (shortest first), to the mean of
+//	the old prediction and the burst that just ended.  This is the
+//	only place the prediction changes.
+//
+//	Called by Yield, before the thread goes back on the ready list,
+//	and by Sleep.
+//----------------------------------------------------------------------
+
+void
+Thread::EndBurst()
+{
+    burstTime = burstTime / 2 + execTime / 2;
+}
+
 //----------------------------------------------------------------------
 // Thread::Yield
 // 	Relinquish the CPU if any other thread is ready to run.
@@ -215,6 +266,9 @@ Thread::Finish ()
 //	original state, in case we are called with interrupts disabled. 
 //
 // 	Similar to Thread::Sleep(), but a little different.
+//
+//	A real-time thread that has used up its budget sleeps instead,
+//	until its next period.
 //----------------------------------------------------------------------
 
 void
@@ -227,8 +281,15 @@ Thread::Yield ()
     
     DEBUG(dbgThread, "Yielding thread: " << name);
     
+    if (kernel->scheduler->OutOfBudget(this)) {
+	kernel->scheduler->ReadyToRun(this);	// throttles it
+	Sleep(FALSE);
+	(void) kernel->interrupt->SetLevel(oldLevel);
+	return;
+    }
     nextThread = kernel->scheduler->FindNextToRun();
     if (nextThread != NULL) {
+	EndBurst();			// before it is queued by burst
 	kernel->scheduler->ReadyToRun(this);
 	kernel->scheduler->Run(nextThread, FALSE);
     }
@@ -266,8 +327,10 @@ Thread::Sleep (bool finishing)
     DEBUG(dbgThread, "Sleeping thread: " << name);
 
     status = BLOCKED;
+    EndBurst();
 	//cout << "debug Thread::Sleep " << name << "wait for Idle\n";
-    while ((nextThread = kernel->scheduler->FindNextToRun()) == NULL) {
+    while ((nextThread = kernel->scheduler->FindNextToRun()) == NULL
+		&& (nextThread = kernel->cpus->Steal()) == NULL) {
 		kernel->interrupt->Idle();	// no one to run, wait for an interrupt
 	}    
     // returns when it's time for us to run
@@ -325,34 +388,34 @@ PLabelToAddr(void *plabel)
 void
 Thread::StackAllocate (VoidFunctionPtr func, void *arg)
 {
-    stack = (int *) AllocBoundedArray(StackSize * sizeof(int));
+    stack = kernel->stackPool->Get(stackSize);	// usually a used one
 
 #ifdef PARISC
     // HP stack works from low addresses to high addresses
     // everyone else works the other way: from high addresses to low addresses
     stackTop = stack + 16;	// HP requires 64-byte frame marker
-    stack[StackSize - 1] = STACK_FENCEPOST;
+    stack[stackSize - 1] = STACK_FENCEPOST;
 #endif
 
 #ifdef SPARC
-    stackTop = stack + StackSize - 96; 	// SPARC stack must contains at 
+    stackTop = stack + stackSize - 96; 	// SPARC stack must contains at 
 					// least 1 activation record 
 					// to start with.
     *stack = STACK_FENCEPOST;
 #endif 
 
 #ifdef PowerPC // RS6000
-    stackTop = stack + StackSize - 16; 	// RS6000 requires 64-byte frame marker
+    stackTop = stack + stackSize - 16; 	// RS6000 requires 64-byte frame marker
     *stack = STACK_FENCEPOST;
 #endif 
 
 #ifdef DECMIPS
-    stackTop = stack + StackSize - 4;	// -4 to be on the safe side!
+    stackTop = stack + stackSize - 4;	// -4 to be on the safe side!
     *stack = STACK_FENCEPOST;
 #endif
 
 #ifdef ALPHA
-    stackTop = stack + StackSize - 8;	// -8 to be on the safe side!
+    stackTop = stack + stackSize - 8;	// -8 to be on the safe side!
     *stack = STACK_FENCEPOST;
 #endif
 
@@ -361,7 +424,7 @@ Thread::StackAllocate (VoidFunctionPtr func, void *arg)
     // the x86 passes the return address on the stack.  In order for SWITCH() 
     // to go to ThreadRoot when we switch to this thread, the return addres 
     // used in SWITCH() must be the starting address of ThreadRoot.
-    stackTop = stack + StackSize - 4;	// -4 to be on the safe side!
+    stackTop = stack + stackSize - 4;	// -4 to be on the safe side!
     *(--stackTop) = (int) ThreadRoot;
     *stack = STACK_FENCEPOST;
 #endif
@@ -40,6 +40,7 @@
 #include "copyright.h"
 #include "utility.h"
 #include "sysdep.h"
+#include "stackpool.h"
 #include "machine.h"
 #include "addrspace.h"
 
@@ -100,6 +101,9 @@ class Thread {
     void Finish();  		// The thread is done executing
     
     void CheckOverflow();   	// Check if thread stack has overflowed
+    void setStackSize(int size) { ASSERT(stack == NULL); stackSize = size; }
+				// StackSize or SmallStackSize words;
+				// set before Fork
     void setStatus(ThreadStatus st) { status = st; }
     ThreadStatus getStatus() { return (status); }
 	char* getName() { return (name); }
@@ -109,6 +113,8 @@ class Thread {
     void SelfTest();		// test whether thread impl is working
 
     void setBurstTime(int t){burstTime = t;}
+    void EndBurst();		// predict the next CPU burst, from the
+				// one that just ended
     int getBurstTime(){return burstTime;}
 
     void setExecTime(int t){execTime = t;}
@@ -120,6 +126,35 @@ class Thread {
     void setLastCheckInQueueTime(int t){lastCheckInQueueTime = t;}
     int getLastCheckInQueueTime(){return lastCheckInQueueTime;}
 
+    void setQueueOrder(unsigned int t){queueOrder = t;}
+    unsigned int getQueueOrder(){return queueOrder;}
+
+    void setCPU(int c){cpu = c;}
+    int getCPU(){return cpu;}
+    void setLastRan(int t){lastRan = t;}
+    int getLastRan(){return lastRan;}
+
+    void setVruntime(double t){vruntime = t;}
+    double getVruntime(){return vruntime;}
+    void setReadySince(int t){readySince = t;}
+    int getReadySince(){return readySince;}
+    void addCPUTicks(int t){cpuTicks += t;}
+    void addReadyTicks(int t){readyTicks += t;}
+
+    bool IsRealTime(){return period > 0;}
+    void setPeriod(int p, int b){period = p; budget = b;}
+    int getPeriod(){return period;}
+    int getBudget(){return budget;}
+    void setBudgetLeft(int t){budgetLeft = t;}
+    int getBudgetLeft(){return budgetLeft;}
+    void setDeadline(int t){deadline = t;}
+    int getDeadline(){return deadline;}
+    void setThrottled(bool t){throttled = t;}
+    bool isThrottled(){return throttled;}
+    void setWakeTime(int t, unsigned int order){wakeTime = t; wakeOrder = order;}
+    int getWakeTime(){return wakeTime;}
+    unsigned int getWakeOrder(){return wakeOrder;}
+
     static void SchedulingTest();
   private:
     // some of the private data for this class is listed above
@@ -127,6 +162,7 @@ class Thread {
     int *stack; 	 	// Bottom of the stack 
 				// NULL if this is the main thread
 				// (If NULL, don't deallocate stack)
+    int stackSize;		// in words
     ThreadStatus status;	// ready, running or blocked
     char* name;
 
@@ -134,8 +170,28 @@ class Thread {
     int burstTime;
     int execTime;
     int lastCheckInQueueTime;    
+    unsigned int queueOrder;	// when it was put in the ready queue,
+				// to keep equal threads first come,
+				// first served
+    int cpu;			// the CPU it last ran on, -1 if none
+    int lastRan;		// when it last left that CPU
+    double vruntime;		// CPU time, scaled by the weight of its
+				// priority (fair scheduling only)
+    int readySince;		// when it was last made ready
+    int cpuTicks;		// time it has run, in all
+    int readyTicks;		// time it has waited to run, in all
+    int period;			// real-time threads only (else 0): it
+    int budget;			// may run budget ticks every period
+    int budgetLeft;		// of its budget for this period
+    int deadline;		// when this period ends
+    bool throttled;		// out of budget until then?
+    int wakeTime;		// when to wake it, if it is asleep in
+				// Alarm::WaitUntil
+    unsigned int wakeOrder;	// when it went to sleep, to wake threads
+				// due together in that order
 
     int   ID;
+    friend class CPUSet;	// starts a thread on each CPU
     void StackAllocate(VoidFunctionPtr func, void *arg);
     				// Allocate a stack for thread.
 				// Used internally by Fork()
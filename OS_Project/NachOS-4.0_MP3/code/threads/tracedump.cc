@@ -0,0 +1,58 @@
+// tracedump.cc
+//	A separate program to print a scheduler trace file, written by
+//	"nachos -trace <file>", either as the text Nachos would have
+//	printed as it ran, or as JSON for chrome://tracing.
+//
+// Usage: tracedump [-json] <file>
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "debug.h"
+#include "sysdep.h"
+#include "schedtrace.h"
+
+Debug *debug;			// for the DEBUG macros in the library
+
+const int EventsPerRead = 256;	// events to read from the file at once
+
+int
+main(int argc, char **argv)
+{
+    TraceEvent events[EventsPerRead];
+    bool json = FALSE, first = TRUE;
+    char *fileName = NULL;
+    int fd, numBytes;
+
+    debug = new Debug("");
+    for (int i = 1; i < argc; i++) {
+	if (strcmp(argv[i], "-json") == 0)
+	    json = TRUE;
+	else
+	    fileName = argv[i];
+    }
+    if (fileName == NULL) {
+	cout << "Usage: tracedump [-json] <file>\n";
+	return 1;
+    }
+    fd = OpenForReadWrite(fileName, TRUE);
+
+    if (json)
+	cout << "{\"traceEvents\":[\n";
+    while ((numBytes = ReadPartial(fd, (char *) events, sizeof(events))) > 0) {
+	ASSERT(numBytes % sizeof(TraceEvent) == 0);	// whole events only
+	for (int i = 0; i < numBytes / (int) sizeof(TraceEvent); i++) {
+	    if (json)
+		SchedTrace::PrintJSON(&events[i], first);
+	    else
+		SchedTrace::Print(&events[i]);
+	    first = FALSE;
+	}
+    }
+    if (json)
+	cout << "\n]}\n";
+    Close(fd);
+    return 0;
+}
@@ -66,9 +66,12 @@ SwapHeader (NoffHeader *noffH)
 //----------------------------------------------------------------------
 
 bool AddrSpace::usedPhysPage[NumPhysPages] = {0};
+int AddrSpace::nextAsid = 1;
 
 AddrSpace::AddrSpace()
 {
+    asid = nextAsid++;
+    profile = NULL;
     pageTable = new TranslationEntry[NumPhysPages];
     for (int i = 0; i < NumPhysPages; i++) {
 	pageTable[i].virtualPage = i;	// for now, virt page # = phys page #
@@ -90,9 +93,13 @@ AddrSpace::AddrSpace()
 
 AddrSpace::~AddrSpace()
 {
+   kernel->machine->FlushTLB(asid);
    for(int i = 0; i < numPages; i++)
 	usedPhysPage[pageTable[i].physicalPage] = false;
    delete pageTable;
+   if (kernel->machine->profile == profile)	// don't leave the machine
+	kernel->machine->profile = NULL;	// counting into it
+   delete profile;
 }
 
 
@@ -138,6 +145,8 @@ AddrSpace::Load(char *fileName)
 #endif
     numPages = divRoundUp(size, PageSize);
     size = numPages * PageSize;
+    if (kernel->profileUserProg)
+	profile = new Profile(fileName, size);
     
     pageTable = new TranslationEntry[numPages];
     for(unsigned int i = 0, j = 0; i < numPages; i++) {
@@ -272,8 +281,45 @@ void AddrSpace::SaveState()
 
 void AddrSpace::RestoreState() 
 {
+    kernel->machine->profile = profile;
+#ifdef USE_TLB
+    kernel->machine->currentAsid = asid;	// entries are tagged, so
+						// no need to flush the TLB
+#else
     kernel->machine->pageTable = pageTable;
     kernel->machine->pageTableSize = numPages;
+    kernel->machine->InvalidateTranslations();
+#endif
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::DumpProfile
+// 	When the program exits, write out its profile (see profile.h).
+//----------------------------------------------------------------------
+
+void
+AddrSpace::DumpProfile()
+{
+    if (profile != NULL)
+	profile->Dump();
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::RefillTLB
+// 	Handle a TLB miss on virtual address "vaddr": load the
+//	translation of its page into the TLB.  Return FALSE if the
+//	address is not part of this address space.
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::RefillTLB(unsigned int vaddr)
+{
+    unsigned int vpn = vaddr / PageSize;
+
+    if (vpn >= numPages || !pageTable[vpn].valid)
+	return FALSE;
+    kernel->machine->LoadTLB(&pageTable[vpn], asid);
+    return TRUE;
 }
 
 
@@ -327,6 +373,97 @@ AddrSpace::Translate(unsigned int vaddr, unsigned int *paddr, int isReadWrite)
     return NoException;
 }
 
+//----------------------------------------------------------------------
+// AddrSpace::CopyFromUser
+//  Copy "size" bytes starting at user virtual address "vaddr" into
+//  the kernel buffer "into".
+//
+//  Consecutive virtual pages need not be consecutive in physical
+//  memory, so we translate the address once per page and bcopy
+//  the whole span that lies within that page.
+//
+//  Return FALSE if some page in the range could not be translated.
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::CopyFromUser(char *into, unsigned int vaddr, int size)
+{
+    unsigned int paddr;
+    int span;
+
+    while (size > 0) {
+        span = min(size, (int) (PageSize - (vaddr % PageSize)));
+        if (Translate(vaddr, &paddr, 0) != NoException)
+            return FALSE;
+        bcopy(&(kernel->machine->mainMemory[paddr]), into, span);
+        into += span;
+        vaddr += span;
+        size -= span;
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::CopyToUser
+//  Copy "size" bytes from the kernel buffer "from" to user virtual
+//  address "vaddr", one page-sized span at a time.  The pages
+//  written are marked dirty.
+//
+//  Return FALSE if some page in the range could not be translated,
+//  or is read-only.
+//----------------------------------------------------------------------
 
+bool
+AddrSpace::CopyToUser(unsigned int vaddr, char *from, int size)
+{
+    unsigned int paddr;
+    int span;
+
+    while (size > 0) {
+        span = min(size, (int) (PageSize - (vaddr % PageSize)));
+        if (Translate(vaddr, &paddr, 1) != NoException)
+            return FALSE;
+        bcopy(from, &(kernel->machine->mainMemory[paddr]), span);
+        from += span;
+        vaddr += span;
+        size -= span;
+    }
+    return TRUE;
+}
 
+//----------------------------------------------------------------------
+// AddrSpace::CopyStringFromUser
+//  Copy the null-terminated string at user virtual address "vaddr"
+//  into the kernel buffer "into", which holds "maxLen" bytes.
+//  Each page is searched for the terminator with memchr, so the
+//  string is still moved a page-sized span at a time.
+//
+//  Return the length of the string, or -1 if it could not be
+//  translated or does not fit in "maxLen" bytes.
+//----------------------------------------------------------------------
 
+int
+AddrSpace::CopyStringFromUser(char *into, unsigned int vaddr, int maxLen)
+{
+    unsigned int paddr;
+    int span, len = 0;
+    char *src, *end;
+
+    while (len < maxLen) {
+        span = min(maxLen - len, (int) (PageSize - (vaddr % PageSize)));
+        if (Translate(vaddr, &paddr, 0) != NoException)
+            return -1;
+        src = &(kernel->machine->mainMemory[paddr]);
+        end = (char *) memchr(src, '\0', span);
+        if (end != NULL) {
+            bcopy(src, into + len, end - src);
+            len += end - src;
+            into[len] = '\0';
+            return len;
+        }
+        bcopy(src, into + len, span);
+        len += span;
+        vaddr += span;
+    }
+    return -1;				// string too long
+}
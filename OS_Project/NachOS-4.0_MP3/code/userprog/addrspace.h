@@ -15,8 +15,11 @@
 
 #include "copyright.h"
 #include "filesys.h"
+#include "profile.h"
 
 #define UserStackSize		1024 	// increase this as necessary!
+#define MaxUserStringLen	256	// longest string (e.g., a file name)
+					// a system call copies in
 
 class AddrSpace {
   public:
@@ -38,12 +41,37 @@ class AddrSpace {
     // to physical address _paddr_. _mode_
     // is 0 for Read, 1 for Write.
     ExceptionType Translate(unsigned int vaddr, unsigned int *paddr, int mode);
+
+    unsigned int Size() { return numPages * PageSize; }
+					// bytes of user virtual memory; no
+					// user buffer can be bigger
+
+    // Move data between user virtual memory and a kernel buffer.
+    // These translate once per page, and copy each page-sized span
+    // in one go.  They return FALSE (or -1) if part of the user
+    // range has no valid translation.
+    bool CopyFromUser(char *into, unsigned int vaddr, int size);
+    bool CopyToUser(unsigned int vaddr, char *from, int size);
+    int CopyStringFromUser(char *into, unsigned int vaddr, int maxLen);
+					// copy a null-terminated string of
+					// at most maxLen bytes (including
+					// the '\0'); return its length
+
+    bool RefillTLB(unsigned int vaddr);	// Load the translation of vaddr
+					// into the TLB; FALSE if there is
+					// none
+
+    void DumpProfile();			// Write out the program's profile,
+					// if it is being profiled
     static bool usedPhysPage[NumPhysPages];
   private:
     TranslationEntry *pageTable;	// Assume linear page table translation
 					// for now!
     unsigned int numPages;		// Number of pages in the virtual 
 					// address space
+    int asid;				// Tags this space's TLB entries
+    Profile *profile;			// NULL unless profiling (-prof)
+    static int nextAsid;
 
     void InitRegisters();		// Initialize user-level CPU registers,
 					// before jumping to user code
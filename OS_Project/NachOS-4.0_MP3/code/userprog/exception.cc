@@ -54,6 +54,8 @@ ExceptionHandler(ExceptionType which)
     int type = kernel->machine->ReadRegister(2);
 	int val;
     int status, exit, threadID, programID;
+    int size;
+    AddrSpace *space = kernel->currentThread->space;
 	DEBUG(dbgSys, "Received Exception " << which << " type: " << type << "\n");
     switch (which) {
     case SyscallException:
@@ -70,11 +72,15 @@ ExceptionHandler(ExceptionType which)
       	case SC_Sleep:
 			val = (int)kernel->machine->ReadRegister(4);
 			cout << "Sleep Time " << val << "(ms) " << endl;
-		//	kernel->alarm->WaitUntil(val);
+			kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
+			kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
+			kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);
+			kernel->alarm->WaitUntil(val);
 			return;
 			break;
 	case SC_Halt:
 			DEBUG(dbgSys, "Shutdown, initiated by user program.\n");
+			space->DumpProfile();
 			SysHalt();
                         cout<<"in exception\n";
 			ASSERTNOTREACHED();
@@ -83,17 +89,23 @@ ExceptionHandler(ExceptionType which)
 			DEBUG(dbgSys, "Message received.\n");
 			val = kernel->machine->ReadRegister(4);
 			{
-			char *msg = &(kernel->machine->mainMemory[val]);
-			cout << msg << endl;
+			char msg[MaxUserStringLen];
+			if (space->CopyStringFromUser(msg, val, MaxUserStringLen) >= 0)
+				cout << msg << endl;
 			}
 			SysHalt();
 			ASSERTNOTREACHED();
 			break;
 	case SC_Open:
 			val = kernel->machine->ReadRegister(4);
-			
-			status = SysOpen(&(kernel->machine->mainMemory[val]));
+			{
+			char name[MaxUserStringLen];
+			if (space->CopyStringFromUser(name, val, MaxUserStringLen) < 0)
+				status = -1;
+			else
+				status = SysOpen(name);
 			kernel->machine->WriteRegister(2, (int) status);
+			}
 
 			kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
 			kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
@@ -104,8 +116,17 @@ ExceptionHandler(ExceptionType which)
 			break;
 	case SC_Write:
 			val = kernel->machine->ReadRegister(4);
-
-			status = SysWrite(&(kernel->machine->mainMemory[val]), (int)kernel->machine->ReadRegister(5),(int)kernel->machine->ReadRegister(6));
+			size = (int)kernel->machine->ReadRegister(5);
+			if (size < 0 || (unsigned int) size > space->Size())
+				status = -1;
+			else {
+				char *buffer = new char[size];
+				if (!space->CopyFromUser(buffer, val, size))
+					status = -1;
+				else
+					status = SysWrite(buffer, size, (int)kernel->machine->ReadRegister(6));
+				delete [] buffer;
+			}
 			kernel->machine->WriteRegister(2, (int) status);
 			kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
 			kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
@@ -115,7 +136,16 @@ ExceptionHandler(ExceptionType which)
 			break;
 	case SC_Read:	
 			val = kernel->machine->ReadRegister(4);
-			status = SysRead(&(kernel->machine->mainMemory[val]), (int)kernel->machine->ReadRegister(5),(int)kernel->machine->ReadRegister(6));
+			size = (int)kernel->machine->ReadRegister(5);
+			if (size < 0 || (unsigned int) size > space->Size())
+				status = -1;
+			else {
+				char *buffer = new char[size];
+				status = SysRead(buffer, size, (int)kernel->machine->ReadRegister(6));
+				if (status > 0 && !space->CopyToUser(val, buffer, status))
+					status = -1;
+				delete [] buffer;
+			}
 			kernel->machine->WriteRegister(2, (int) status);
 			kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
 			kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
@@ -136,15 +166,30 @@ ExceptionHandler(ExceptionType which)
 			kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
 			kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);
 			
+			return;
+			ASSERTNOTREACHED();
+			break;
+	case SC_SetRealTime:
+			DEBUG(dbgSys, "SetRealTime " << kernel->machine->ReadRegister(4) << " " << kernel->machine->ReadRegister(5) << "\n");
+			status = SysSetRealTime((int)kernel->machine->ReadRegister(4),
+					(int)kernel->machine->ReadRegister(5));
+			kernel->machine->WriteRegister(2, (int) status);
+
+			kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
+			kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
+			kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);
+
 			return;
 			ASSERTNOTREACHED();
 			break;
 	case SC_Create:
 			val = kernel->machine->ReadRegister(4);
 			{
-			char *filename = &(kernel->machine->mainMemory[val]);
-			//cout << filename << endl;
-			status = SysCreate(filename);
+			char filename[MaxUserStringLen];
+			if (space->CopyStringFromUser(filename, val, MaxUserStringLen) < 0)
+				status = 0;
+			else
+				status = SysCreate(filename);
 			kernel->machine->WriteRegister(2, (int) status);
 			}
 			kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
@@ -181,6 +226,7 @@ ExceptionHandler(ExceptionType which)
 			DEBUG(dbgAddr, "Program exit\n");
             val=kernel->machine->ReadRegister(4);
             cout << "return value:" << val << endl;
+			space->DumpProfile();
 			kernel->currentThread->Finish();
             break;
       	default:
@@ -188,6 +234,13 @@ ExceptionHandler(ExceptionType which)
 			break;
 		}
 		break;
+	case PageFaultException:	// a TLB miss: load the entry, and
+					// re-execute the instruction
+		val = kernel->machine->ReadRegister(BadVAddrReg);
+		if (kernel->machine->tlb != NULL && space->RefillTLB(val))
+			return;
+		cerr << "Bad virtual address " << val << "\n";
+		break;
 	default:
 		cerr << "Unexpected user mode exception " << (int)which << "\n";
 		break;
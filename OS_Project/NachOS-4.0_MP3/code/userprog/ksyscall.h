@@ -59,4 +59,17 @@ int SysClose(OpenFileId id)
 {
 	return kernel->interrupt->Close(id);
 }
+
+int SysSetRealTime(int period, int budget)
+{
+	// return value
+	// 1: admitted
+	// 0: rejected
+	IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+	bool admitted = kernel->scheduler->Admit(kernel->currentThread,
+							period, budget);
+
+	(void) kernel->interrupt->SetLevel(oldLevel);
+	return admitted ? 1 : 0;
+}
 #endif /* ! __USERPROG_KSYSCALL_H__ */
@@ -0,0 +1,294 @@
+// profile.cc
+//	Routines to profile a user program, and to write out the
+//	profile when the program exits.  See profile.h.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "profile.h"
+#include "main.h"
+
+// Number of PCs listed in the flat profile
+static const int NumHotPCs = 20;
+
+// Longest call stack written to the folded file; deeper frames
+// are left out
+static const int MaxFoldedPath = 4096;
+
+//----------------------------------------------------------------------
+// CallNode::CallNode
+// 	Create a node for a call of the function at "entryPoint" from
+//	"caller" (NULL for the program's entry point).
+//----------------------------------------------------------------------
+
+CallNode::CallNode(int entryPoint, CallNode *caller)
+{
+    entry = entryPoint;
+    count = 0;
+    parent = caller;
+    children = new List<CallNode *>;
+}
+
+CallNode::~CallNode()
+{
+    while (!children->IsEmpty())
+	delete children->RemoveFront();
+    delete children;
+}
+
+//----------------------------------------------------------------------
+// CallNode::Callee
+// 	Return the node for a call from here to "entryPoint", creating
+//	it on the first such call.
+//----------------------------------------------------------------------
+
+CallNode *
+CallNode::Callee(int entryPoint)
+{
+    ListIterator<CallNode *> it(children);
+    CallNode *node;
+
+    for (; !it.IsDone(); it.Next())
+	if (it.Item()->entry == entryPoint)
+	    return it.Item();
+    node = new CallNode(entryPoint, this);
+    children->Append(node);
+    return node;
+}
+
+//----------------------------------------------------------------------
+// Profile::Profile
+// 	Start profiling the program in file "programName", whose address
+//	space is "size" bytes.  Reads the program's symbols, if any.
+//----------------------------------------------------------------------
+
+Profile::Profile(char *programName, int size)
+{
+    char symFile[256];
+
+    name = new char[strlen(programName) + 1];
+    strcpy(name, programName);
+    numWords = divRoundUp(size, 4);
+    pcCounts = new unsigned int[numWords];
+    bzero(pcCounts, numWords * sizeof(unsigned int));
+    root = current = new CallNode(0, NULL);
+
+    numSymbols = 0;
+    symbolAddr = NULL;
+    symbolName = NULL;
+    snprintf(symFile, sizeof(symFile), "%s.sym", programName);
+    ReadSymbols(symFile);
+}
+
+Profile::~Profile()
+{
+    delete [] name;
+    delete [] pcCounts;
+    delete root;
+    for (int i = 0; i < numSymbols; i++)
+	delete [] symbolName[i];
+    delete [] symbolAddr;
+    delete [] symbolName;
+}
+
+//----------------------------------------------------------------------
+// Profile::ReadSymbols
+// 	Read a symbol file written by coff2noff: one function per line,
+//	"<hex address> <name>".  The functions are kept sorted by
+//	address.  A missing file just leaves the profile without names.
+//----------------------------------------------------------------------
+
+void
+Profile::ReadSymbols(char *fileName)
+{
+    int fd = OpenForReadWrite(fileName, FALSE);
+    char *text, *p, symbol[256];
+    int length, addr, used;
+
+    if (fd < 0)
+	return;
+    Lseek(fd, 0, 2);
+    length = Tell(fd);
+    Lseek(fd, 0, 0);
+    text = new char[length + 1];
+    Read(fd, text, length);
+    text[length] = '\0';
+    Close(fd);
+
+    for (int pass = 0; pass < 2; pass++) {	// count, then store
+	numSymbols = 0;
+	for (p = text; sscanf(p, "%x %255s%n", &addr, symbol, &used) == 2;
+								p += used) {
+	    if (pass == 1) {
+		int i = numSymbols;		// insertion sort by address
+
+		while (i > 0 && symbolAddr[i - 1] > addr) {
+		    symbolAddr[i] = symbolAddr[i - 1];
+		    symbolName[i] = symbolName[i - 1];
+		    i--;
+		}
+		symbolAddr[i] = addr;
+		symbolName[i] = new char[strlen(symbol) + 1];
+		strcpy(symbolName[i], symbol);
+	    }
+	    numSymbols++;
+	}
+	if (pass == 0) {
+	    symbolAddr = new int[numSymbols];
+	    symbolName = new char *[numSymbols];
+	}
+    }
+    delete [] text;
+    DEBUG(dbgAddr, "Read " << numSymbols << " symbols from " << fileName);
+}
+
+//----------------------------------------------------------------------
+// Profile::FindSymbol
+// 	Return the index of the function containing "addr" -- the one
+//	with the highest address not above it -- or -1 if none.
+//----------------------------------------------------------------------
+
+int
+Profile::FindSymbol(int addr)
+{
+    int low = 0, high = numSymbols - 1, mid;
+
+    while (low <= high) {
+	mid = (low + high) / 2;
+	if (symbolAddr[mid] <= addr)
+	    low = mid + 1;
+	else
+	    high = mid - 1;
+    }
+    return high;
+}
+
+//----------------------------------------------------------------------
+// Profile::SymbolName
+// 	Put the name of the function at "addr" into "buf", with the
+//	offset into the function if "addr" is not its entry point.
+//----------------------------------------------------------------------
+
+void
+Profile::SymbolName(int addr, char *buf)
+{
+    int i = FindSymbol(addr);
+
+    if (i < 0)
+	sprintf(buf, "0x%x", addr);
+    else if (symbolAddr[i] == addr)
+	sprintf(buf, "%s", symbolName[i]);
+    else
+	sprintf(buf, "%s+0x%x", symbolName[i], addr - symbolAddr[i]);
+}
+
+//----------------------------------------------------------------------
+// Profile::Dump
+// 	Write the flat profile to <program>.prof, and the call stacks
+//	to <program>.folded.
+//----------------------------------------------------------------------
+
+void
+Profile::Dump()
+{
+    char fileName[256], line[512], sym[300];
+    unsigned int *funcCounts = new unsigned int[numSymbols + 1];
+    int *order = new int[numSymbols + 1];
+    char *path = new char[MaxFoldedPath];
+    int hot[NumHotPCs], numHot;
+    double total = 0;
+    int fd, i, j, n;
+
+    // instructions per function; the last slot is code before the
+    // first symbol
+    bzero(funcCounts, (numSymbols + 1) * sizeof(unsigned int));
+    for (i = 0; i < numWords; i++) {
+	if (pcCounts[i] == 0)
+	    continue;
+	j = FindSymbol(i * 4);
+	funcCounts[j < 0 ? numSymbols : j] += pcCounts[i];
+	total += pcCounts[i];
+    }
+    for (i = 0; i <= numSymbols; i++) {		// sort, most first
+	for (j = i; j > 0 && funcCounts[order[j - 1]] < funcCounts[i]; j--)
+	    order[j] = order[j - 1];
+	order[j] = i;
+    }
+
+    snprintf(fileName, sizeof(fileName), "%s.prof", name);
+    fd = OpenForWrite(fileName);
+    n = sprintf(line, "Flat profile of %s: %.0f instructions\n\n"
+			"  %%time  instructions  function\n", name, total);
+    WriteFile(fd, line, n);
+    for (i = 0; i <= numSymbols && funcCounts[order[i]] > 0; i++) {
+	j = order[i];
+	n = sprintf(line, "%7.2f %13u  %s\n", 100.0 * funcCounts[j] / total,
+		funcCounts[j], j < numSymbols ? symbolName[j] : "<unknown>");
+	WriteFile(fd, line, n);
+    }
+
+    for (i = 0, n = 0; i < numWords; i++) {	// the hottest PCs, most
+	if (pcCounts[i] == 0)			// first
+	    continue;
+	if (n == NumHotPCs && pcCounts[hot[n - 1]] >= pcCounts[i])
+	    continue;
+	if (n < NumHotPCs)
+	    n++;
+	for (j = n - 1; j > 0 && pcCounts[hot[j - 1]] < pcCounts[i]; j--)
+	    hot[j] = hot[j - 1];
+	hot[j] = i;
+    }
+    numHot = n;
+    n = sprintf(line, "\n  %%time  instructions  pc\n");
+    WriteFile(fd, line, n);
+    for (i = 0; i < numHot; i++) {
+	SymbolName(hot[i] * 4, sym);
+	n = sprintf(line, "%7.2f %13u  0x%x %s\n",
+		100.0 * pcCounts[hot[i]] / total, pcCounts[hot[i]],
+		hot[i] * 4, sym);
+	WriteFile(fd, line, n);
+    }
+    Close(fd);
+
+    snprintf(fileName, sizeof(fileName), "%s.folded", name);
+    fd = OpenForWrite(fileName);
+    DumpFolded(fd, root, path, 0);
+    Close(fd);
+
+    delete [] path;
+    delete [] funcCounts;
+    delete [] order;
+}
+
+//----------------------------------------------------------------------
+// Profile::DumpFolded
+// 	Write a line "<path>;<function> <count>" for "node" and each
+//	node below it that executed any instructions.  "path" holds the
+//	first "length" characters of the call stack above "node".
+//----------------------------------------------------------------------
+
+void
+Profile::DumpFolded(int fd, CallNode *node, char *path, int length)
+{
+    char sym[300], line[64];
+    int n;
+
+    SymbolName(node->entry, sym);
+    if (length + (int) strlen(sym) + 2 < MaxFoldedPath) {
+	if (length > 0)
+	    path[length++] = ';';
+	strcpy(path + length, sym);
+	length += strlen(sym);
+    }
+    if (node->count > 0) {
+	WriteFile(fd, path, length);
+	n = sprintf(line, " %u\n", node->count);
+	WriteFile(fd, line, n);
+    }
+
+    ListIterator<CallNode *> it(node->children);
+    for (; !it.IsDone(); it.Next())
+	DumpFolded(fd, it.Item(), path, length);
+}
@@ -0,0 +1,86 @@
+// profile.h
+//	Data structures to profile a user program: how many instructions
+//	it executes at each PC, in each function, and in each call stack.
+//
+//	The machine simulation counts every instruction that completes
+//	(see Machine::Execute), and follows calls (jal, jalr) and returns
+//	(jr $31) through a call tree.  When the program exits, two files
+//	are written next to it:
+//
+//	    <program>.prof	-- flat profile: instructions per function,
+//				   and the most frequently executed PCs
+//	    <program>.folded	-- one line per call stack, "main;f;g count",
+//				   the input of the usual flame graph tools
+//
+//	Function names come from <program>.sym, which coff2noff writes
+//	from the COFF symbol table; without it, functions are shown by
+//	address.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "copyright.h"
+#include "list.h"
+
+// A node of the call tree: one function, as called along one path
+// from the program's entry point.
+
+class CallNode {
+  public:
+    CallNode(int entryPoint, CallNode *caller);
+    ~CallNode();			// also deletes the callees
+
+    CallNode *Callee(int entryPoint);	// find or add the node for a
+					// call from here
+
+    int entry;				// address of the function
+    unsigned int count;			// instructions executed in it
+					// (not in its callees)
+    CallNode *parent;			// NULL for the entry point
+    List<CallNode *> *children;
+};
+
+class Profile {
+  public:
+    Profile(char *programName, int size);
+					// Profile a program, whose address
+					// space is "size" bytes
+    ~Profile();
+
+    void Count(int pc) {		// an instruction at "pc" completed
+	pcCounts[((unsigned) pc / 4) % numWords]++;
+	current->count++;
+    }
+    void Call(int target) { current = current->Callee(target); }
+    void Return() {
+	if (current->parent != NULL)
+	    current = current->parent;
+    }
+
+    void Dump();			// Write out <program>.prof and
+					// <program>.folded
+
+  private:
+    char *name;				// the program's file name
+    unsigned int *pcCounts;		// instructions executed at each word
+    int numWords;			// of the address space
+    CallNode *root;			// call tree, and where we are in it
+    CallNode *current;
+
+    int numSymbols;			// functions, sorted by address
+    int *symbolAddr;
+    char **symbolName;
+
+    void ReadSymbols(char *fileName);
+    int FindSymbol(int addr);		// index of the function containing
+					// "addr", or -1
+    void SymbolName(int addr, char *buf);
+					// name of the function at "addr"
+    void DumpFolded(int fd, CallNode *node, char *path, int length);
+};
+
+#endif // PROFILE_H
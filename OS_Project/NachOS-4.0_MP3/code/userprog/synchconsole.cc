@@ -8,6 +8,7 @@
 
 #include "copyright.h"
 #include "synchconsole.h"
+#include "string.h"
 
 //----------------------------------------------------------------------
 // SynchConsoleInput::SynchConsoleInput
@@ -78,6 +79,7 @@ SynchConsoleOutput::SynchConsoleOutput(char *outputFile)
     consoleOutput = new ConsoleOutput(outputFile, this);
     lock = new Lock("console out");
     waitFor = new Semaphore("console out", 0);
+    waiting = FALSE;
 }
 
 //----------------------------------------------------------------------
@@ -92,6 +94,42 @@ SynchConsoleOutput::~SynchConsoleOutput()
     delete waitFor;
 }
 
+//----------------------------------------------------------------------
+// SynchConsoleOutput::Write
+//      Write characters to the console display.  They are handed to
+//	the display a buffer full at a time; we only wait if the
+//	display's buffer fills up.
+//
+//	"buffer" -- the characters to write
+//	"size" -- how many of them
+//----------------------------------------------------------------------
+
+void
+SynchConsoleOutput::Write(char *buffer, int size)
+{
+    int n;
+
+    lock->Acquire();
+    while ((n = consoleOutput->Write(buffer, size)) < size) {
+	buffer += n;
+	size -= n;
+	waiting = TRUE;
+	waitFor->P();		// wait for room in the buffer
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// SynchConsoleOutput::PutString
+//      Write a null-terminated string to the console display.
+//----------------------------------------------------------------------
+
+void
+SynchConsoleOutput::PutString(char *str)
+{
+    Write(str, strlen(str));
+}
+
 //----------------------------------------------------------------------
 // SynchConsoleOutput::PutChar
 //      Write a character to the console display, waiting if necessary.
@@ -100,33 +138,44 @@ SynchConsoleOutput::~SynchConsoleOutput()
 void
 SynchConsoleOutput::PutChar(char ch)
 {
-    lock->Acquire();
-    consoleOutput->PutChar(ch);
-    waitFor->P();
-    lock->Release();
+    Write(&ch, sizeof(char));
 }
+
 //---------------------------------------------------------------------
-//
-//
+// SynchConsoleOutput::PutInt
+//      Write a number in decimal to the console display, followed
+//	by a newline.
 //---------------------------------------------------------------------
 
 void
 SynchConsoleOutput::PutInt(int number)
 {
-    lock->Acquire();
-    consoleOutput->PutInt(number);
-    waitFor->P();
-    lock->Release();
+    char digits[16];
+    int index = sizeof(digits);
+    unsigned int n = (number < 0) ? -(unsigned int) number : number;
+
+    digits[--index] = '\n';
+    do {
+	digits[--index] = '0' + (n % 10);
+	n /= 10;
+    } while (n > 0);
+    if (number < 0)
+	digits[--index] = '-';
+    Write(digits + index, sizeof(digits) - index);
 }
 
 //----------------------------------------------------------------------
 // SynchConsoleOutput::CallBack
-//      Interrupt handler called when it's safe to send the next 
-//	character can be sent to the display.
+//      Interrupt handler called when the display has taken a buffer
+//	full, so there is room for more; wake up the writer, if it
+//	is waiting.
 //----------------------------------------------------------------------
 
 void
 SynchConsoleOutput::CallBack()
 {
-    waitFor->V();
+    if (waiting) {
+	waiting = FALSE;
+	waitFor->V();
+    }
 }
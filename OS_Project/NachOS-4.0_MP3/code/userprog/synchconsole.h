@@ -40,12 +40,16 @@ class SynchConsoleOutput : public CallBackObj {
     SynchConsoleOutput(char *outputFile); // Initialize the console device
     ~SynchConsoleOutput();
 
+    void Write(char *buffer, int size);
+				// Write characters, waiting if necessary
+    void PutString(char *str);	// Write a null-terminated string
     void PutChar(char ch);	// Write a character, waiting if necessary
-    void PutInt(int number); 
+    void PutInt(int number); 	// Write a number, and a newline
   private:
     ConsoleOutput *consoleOutput;// the hardware display
     Lock *lock;			// only one writer at a time
     Semaphore *waitFor;		// wait for callBack
+    bool waiting;		// is anyone waiting for it?
 
     void CallBack();		// called when more data can be written
 };
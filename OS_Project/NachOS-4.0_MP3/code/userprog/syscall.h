@@ -36,6 +36,7 @@
 #define SC_ThreadJoin   15
 #define SC_PrintInt     16
 #define SC_Sleep	17
+#define SC_SetRealTime	18
 #define SC_Add		42
 #define SC_MSG		100
 
@@ -183,6 +184,15 @@ int ThreadJoin(ThreadId id);
  */
 void ThreadExit(int ExitCode);	
 
+/* Real-time scheduling: from now on, run the current thread for up to
+ * "budget" ticks in every "period" ticks, ahead of ordinary threads,
+ * earliest deadline first.  Once the budget for a period is used up,
+ * the thread waits for the next period.
+ * Return 1 if the thread was admitted, 0 if the CPU is already too
+ * busy with real-time threads (or the arguments make no sense).
+ */
+int SetRealTime(int period, int budget);
+
 #endif /* IN_ASM */
 
 #endif /* SYSCALL_H */
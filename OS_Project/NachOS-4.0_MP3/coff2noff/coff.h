@@ -46,4 +46,42 @@ struct scnhdr {
         unsigned short  s_nlnno;        /* number of gp histogram entries */
         long            s_flags;        /* flags */
       };
+
+/* The symbol table ("symbolic header" at f_symptr).  Only the external
+ * symbols are described here; each is an EXTR whose name is at "iss"
+ * in the external string table.
+ */
+typedef struct hdrr {
+        short   magic;          /* magicSym                             */
+        short   vstamp;         /* version stamp                        */
+        long    ilineMax, cbLine, cbLineOffset;
+        long    idnMax, cbDnOffset;
+        long    ipdMax, cbPdOffset;
+        long    isymMax, cbSymOffset;
+        long    ioptMax, cbOptOffset;
+        long    iauxMax, cbAuxOffset;
+        long    issMax, cbSsOffset;
+        long    issExtMax;      /* size of the external string table    */
+        long    cbSsExtOffset;  /* file ptr to it                       */
+        long    ifdMax, cbFdOffset;
+        long    crfd, cbRfdOffset;
+        long    iextMax;        /* number of external symbols           */
+        long    cbExtOffset;    /* file ptr to them                     */
+      } HDRR;
+
+#define magicSym        0x7009
+
+typedef struct extr {
+        unsigned short  flags;          /* jmptbl, cobol_main, weakext  */
+        short           ifd;            /* file the symbol is defined in */
+        long            iss;            /* name: offset in string table */
+        long            value;          /* address                      */
+        unsigned long   bits;           /* st (6 bits), sc (5), index   */
+      } EXTR;
+
+#define SYM_ST(bits)    ((bits) & 0x3f)         /* symbol type */
+#define SYM_SC(bits)    (((bits) >> 6) & 0x1f)  /* storage class */
+#define stProc          6
+#define stStaticProc    14
+#define scText          1
  
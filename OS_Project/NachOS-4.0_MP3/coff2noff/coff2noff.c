@@ -20,6 +20,10 @@
 #endif
  *
  *
+ * If the COFF file has a symbol table, the procedures in it are also
+ * written to <noffFileName>.sym, one "<hex address> <name>" per line,
+ * for the Nachos profiler (see userprog/profile.h).
+ *
  * Copyright (c) 1992-1993 The Regents of the University of California.
  * All rights reserved.  See copyright.h for copyright notice and limitation 
  * of liability and disclaimer of warranty provisions.
@@ -148,6 +152,56 @@ void Write(int fd, char *buf, int nBytes)
     }
 }
 
+/* write the external procedures of the COFF symbol table to <noff>.sym;
+ * it's not an error for there to be none
+ */
+void WriteSymbols(int fdIn, struct filehdr *fileh)
+{
+    HDRR symh;
+    EXTR ext;
+    char *strings, *symFileName;
+    FILE *out;
+    int i, n = 0;
+
+    if (WordToHost(fileh->f_symptr) == 0)
+	return;
+    lseek(fdIn, WordToHost(fileh->f_symptr), 0);
+    ReadStruct(fdIn, symh);
+    if (ShortToHost(symh.magic) != magicSym)
+	return;
+    symh.issExtMax = WordToHost(symh.issExtMax);
+    symh.iextMax = WordToHost(symh.iextMax);
+
+    strings = malloc(symh.issExtMax + 1);
+    lseek(fdIn, WordToHost(symh.cbSsExtOffset), 0);
+    Read(fdIn, strings, symh.issExtMax);
+    strings[symh.issExtMax] = '\0';
+
+    symFileName = malloc(strlen(noffFileName) + 5);
+    sprintf(symFileName, "%s.sym", noffFileName);
+    if ((out = fopen(symFileName, "w")) == NULL) {
+	perror(symFileName);
+	exit(1);
+    }
+    lseek(fdIn, WordToHost(symh.cbExtOffset), 0);
+    for (i = 0; i < symh.iextMax; i++) {
+	ReadStruct(fdIn, ext);
+	ext.bits = WordToHost(ext.bits);
+	ext.iss = WordToHost(ext.iss);
+	if ((SYM_ST(ext.bits) == stProc || SYM_ST(ext.bits) == stStaticProc)
+		&& SYM_SC(ext.bits) == scText
+		&& ext.iss >= 0 && ext.iss < symh.issExtMax) {
+	    fprintf(out, "%x %s\n", (unsigned int) WordToHost(ext.value),
+							&strings[ext.iss]);
+	    n++;
+	}
+    }
+    fclose(out);
+    free(strings);
+    printf("Wrote %d symbols to %s\n", n, symFileName);
+    free(symFileName);
+}
+
 int main(int argc, char **argv)
 {
     int fdIn, fdOut, numsections, i, inNoffFile;
@@ -294,6 +348,7 @@ int main(int argc, char **argv)
     SwapHeader(&noffH);
     
     Write(fdOut, (char *)&noffH, sizeof(NoffHeader));
+    WriteSymbols(fdIn, &fileh);
     close(fdIn);
     close(fdOut);
     exit(0);
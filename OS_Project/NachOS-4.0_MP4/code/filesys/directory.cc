@@ -2,10 +2,11 @@
 //	Routines to manage a directory of file names.
 //
 //	The directory is a table of fixed length entries; each
-//	entry represents a single file, and contains the file name,
-//	and the location of the file header on disk.  The fixed size
-//	of each directory entry means that we have the restriction
-//	of a fixed maximum size for file names.
+//	entry represents a single file, and contains the location of
+//	the file header on disk, and of the file name.  Names are
+//	stored back to back in a name heap that follows the table, so
+//	a long name costs only its own length.  Space of removed names
+//	is reclaimed by compacting the heap when it fills up.
 //
 //	The constructor initializes an empty directory of a certain size;
 //	we use ReadFrom/WriteBack to fetch the contents of the directory
@@ -44,6 +45,9 @@ Directory::Directory(int size)
     tableSize = size;
     for (int i = 0; i < tableSize; i++)
 	table[i].inUse = FALSE;
+    names = new char[NameHeapSize];
+    memset(names, 0, NameHeapSize);
+    namesUsed = 0;
 }
 
 //----------------------------------------------------------------------
@@ -54,11 +58,13 @@ Directory::Directory(int size)
 Directory::~Directory()
 {
     delete [] table;
+    delete [] names;
 }
 
 //----------------------------------------------------------------------
 // Directory::FetchFrom
-// 	Read the contents of the directory from disk.
+// 	Read the contents of the directory from disk.  Only the used
+//	part of the name heap is read.
 //
 //	"file" -- file containing the directory contents
 //----------------------------------------------------------------------
@@ -67,6 +73,11 @@ void
 Directory::FetchFrom(OpenFile *file)
 {
     (void) file->ReadAt((char *)table, tableSize * sizeof(DirectoryEntry), 0);
+    namesUsed = 0;
+    for (int i = 0; i < tableSize; i++)
+	if (table[i].inUse)
+	    namesUsed = max(namesUsed, table[i].nameOffset + table[i].nameLength + 1);
+    (void) file->ReadAt(names, namesUsed, tableSize * sizeof(DirectoryEntry));
 }
 
 //----------------------------------------------------------------------
@@ -80,6 +91,25 @@ void
 Directory::WriteBack(OpenFile *file)
 {
     (void) file->WriteAt((char *)table, tableSize * sizeof(DirectoryEntry), 0);
+    (void) file->WriteAt(names, namesUsed, tableSize * sizeof(DirectoryEntry));
+}
+
+//----------------------------------------------------------------------
+// Directory::HashName
+// 	Return a hash (FNV-1a) of the first "length" characters of "name".
+//	FindIndex only compares names whose hashes match.
+//----------------------------------------------------------------------
+
+unsigned int
+Directory::HashName(char *name, int length)
+{
+    unsigned int hash = 2166136261u;
+
+    for (int i = 0; i < length; i++) {
+	hash ^= (unsigned char) name[i];
+	hash *= 16777619u;
+    }
+    return hash;
 }
 
 //----------------------------------------------------------------------
@@ -93,14 +123,19 @@ Directory::WriteBack(OpenFile *file)
 char*
 Directory::GetNameWithId(int id)
 {
-    return table[id].name;
+    return &names[table[id].nameOffset];
 }
 
 int
 Directory::FindIndex(char *name)
 {
+    int length = strlen(name);
+    unsigned int hash = HashName(name, length);
+
     for (int i = 0; i < tableSize; i++)
-        if (table[i].inUse && !strncmp(table[i].name, name, FileNameMaxLen))
+        if (table[i].inUse && table[i].nameHash == hash
+		&& table[i].nameLength == length
+		&& !memcmp(&names[table[i].nameOffset], name, length))
 	    return i;
     return -1;		// name not in directory
 }
@@ -143,37 +178,76 @@ Directory::Find(char *name)
 bool
 Directory::Add(char *name, int newSector)
 {
-    if (FindIndex(name) != -1)
+    return AddEntry(name, newSector, FALSE);
+}
+
+bool
+Directory::AddDir(char *name, int newSector)
+{
+    return AddEntry(name, newSector, TRUE);
+}
+
+//----------------------------------------------------------------------
+// Directory::AddEntry
+// 	Add a file or directory entry, copying "name" into the name heap.
+//	Return FALSE if the name is too long or already in the directory,
+//	or if the table or the name heap is full.
+//
+//	"dir" -- is the new entry a directory?
+//----------------------------------------------------------------------
+
+bool
+Directory::AddEntry(char *name, int newSector, bool dir)
+{
+    int length = strlen(name);
+
+    if (length > FileNameMaxLen || FindIndex(name) != -1)
 	return FALSE;
 
     for (int i = 0; i < tableSize; i++)
         if (!table[i].inUse) {
+	    if (namesUsed + length + 1 > NameHeapSize)
+		CompactNames();
+	    if (namesUsed + length + 1 > NameHeapSize)
+		return FALSE;	// no room for the name
             table[i].inUse = TRUE;
-            strncpy(table[i].name, name, FileNameMaxLen);
             table[i].sector = newSector;
-	    table[i].dir = FALSE;
-        return TRUE;
+	    table[i].dir = dir;
+	    table[i].nameOffset = namesUsed;
+	    table[i].nameLength = length;
+	    table[i].nameHash = HashName(name, length);
+	    bcopy(name, &names[namesUsed], length + 1);
+	    namesUsed += length + 1;
+	    return TRUE;
 	}
     return FALSE;	// no space.  Fix when we have extensible files.
 }
 
-bool
-Directory::AddDir(char *name, int newSector)
+//----------------------------------------------------------------------
+// Directory::CompactNames
+// 	Rebuild the name heap with only the names of entries in use, so
+//	that space left by removed entries can be reused.
+//----------------------------------------------------------------------
+
+void
+Directory::CompactNames()
 {
-    if(FindIndex(name) != -1)
-	return FALSE;
+    char *packed = new char[NameHeapSize];
+    int used = 0;
 
-    for(int i = 0; i < tableSize; i++)
-	if(!table[i].inUse) {
-	    table[i].inUse = TRUE;
-	    strncpy(table[i].name, name, FileNameMaxLen);
-	    table[i].sector = newSector;
-	    table[i].dir = TRUE;
-	    return TRUE;
-    printf("addDir\n");
+    memset(packed, 0, NameHeapSize);
+    for (int i = 0; i < tableSize; i++)
+	if (table[i].inUse) {
+	    bcopy(&names[table[i].nameOffset], &packed[used],
+						table[i].nameLength + 1);
+	    table[i].nameOffset = used;
+	    used += table[i].nameLength + 1;
 	}
-    return FALSE;
+    delete [] names;
+    names = packed;
+    namesUsed = used;
 }
+
 //----------------------------------------------------------------------
 // Directory::Remove
 // 	Remove a file name from the directory.  Return TRUE if successful;
@@ -205,7 +279,7 @@ Directory::List(bool recursive, int tabCount)
     if(!recursive){
    	for (int i = 0; i < tableSize; i++)
 	    if (table[i].inUse){
-	    	printf("[%d] %s ", i, table[i].name);
+	    	printf("[%d] %s ", i, GetNameWithId(i));
 	    	if(table[i].dir) printf("D\n");
 	    	else printf("F\n");
    	    }
@@ -217,7 +291,7 @@ Directory::List(bool recursive, int tabCount)
             if(table[i].inUse)
             {
                 for(int j = 0; j < tabCount; j++) printf("\t");
-                printf("[%d] %s ", i, table[i].name);
+                printf("[%d] %s ", i, GetNameWithId(i));
 
                 if(table[i].dir)
                 {
@@ -250,7 +324,7 @@ Directory::Print()
     printf("Directory contents:\n");
     for (int i = 0; i < tableSize; i++)
 	if (table[i].inUse) {
-	    printf("Name: %s, Sector: %d\n", table[i].name, table[i].sector);
+	    printf("Name: %s, Sector: %d\n", GetNameWithId(i), table[i].sector);
 	    hdr->FetchFrom(table[i].sector);
 	    hdr->Print();
 	}
@@ -6,6 +6,10 @@
 //	where to find its file header (the data structure describing
 //	where to find the file's data blocks) on disk.
 //
+//	The names themselves are variable length, and are packed into
+//	a "name heap" stored after the table; each entry only records
+//	where its name is, how long it is, and a hash of it.
+//
 //      We assume mutual exclusion is provided by the caller.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
@@ -19,8 +23,9 @@
 
 #include "openfile.h"
 
-#define FileNameMaxLen 		9	// for simplicity, we assume 
-					// file names are <= 9 characters long
+#define FileNameMaxLen 		255	// longest file name we accept
+#define NameHeapSize		1024	// bytes for all the names in one
+					// directory, including their '\0's
 
 // The following class defines a "directory entry", representing a file
 // in the directory.  Each entry gives the name of the file, and where
@@ -32,11 +37,14 @@
 class DirectoryEntry {
   public:
     bool inUse;				// Is this directory entry in use?
+    bool dir;
+    short nameLength;			// Length of the name, without '\0'
     int sector;				// Location on disk to find the 
 					//   FileHeader for this file 
-    char name[FileNameMaxLen + 1];	// Text name for file, with +1 for 
-					// the trailing '\0'
-    bool dir;
+    int nameOffset;			// Where the name starts in the
+					//   directory's name heap
+    unsigned int nameHash;		// HashName of the name, compared
+					//   before the name itself
 };
 
 // The following class defines a UNIX-like "directory".  Each entry in
@@ -64,6 +72,8 @@ class Directory {
 
     bool Add(char *name, int newSector);  // Add a file name into the directory
     bool AddDir(char *name, int newSector);    
+    static unsigned int HashName(char *name, int length);
+					// Hash used to speed up lookups
     bool IsDir(int sector){return table[sector].dir;}
     bool Remove(char *name,bool recursive = false);		// Remove a file from the directory
     int getTableSize(){return tableSize;}
@@ -79,17 +89,24 @@ class Directory {
 					//  table corresponding to "name"
     int GetSectorWithId(int id);
   private:
+    bool AddEntry(char *name, int newSector, bool dir);
+					// Add a file or directory entry
+    void CompactNames();		// Squeeze removed names out of
+					//  the name heap
   
 	/*
 		MP4 Hint:
 		Directory is actually a "file", be careful of how it works with OpenFile and FileHdr.
-		Disk part: table
-		In-core part: tableSize
+		Disk part: table, names
+		In-core part: tableSize, namesUsed
 	*/
   
     int tableSize;			// Number of directory entries
     DirectoryEntry *table;		// Table of pairs: 
 					// <file name, file header location> 
+    char *names;			// Name heap, NameHeapSize bytes
+    int namesUsed;			// Bytes of the heap in use, including
+					// names of removed entries
 
 };
 
@@ -43,6 +43,7 @@ FileHeader::FileHeader()
 	numBytes = 0;
 	numSectors = 0;
 	memset(dataSectors, -1, sizeof(dataSectors));
+	cachedSector[0] = cachedSector[1] = -1;
 }
 
 //----------------------------------------------------------------------
@@ -159,6 +160,7 @@ FileHeader::AllocateIndirectSpace(PersistentBitmap *freeMap, int fileSize, int s
 	}
     }
     WriteBack(sector, (char*) indirect);
+    delete indirect;
     return fileSize - numBytes;
 }
 
@@ -180,25 +182,25 @@ FileHeader::AllocateDoubleIndirectBlock(PersistentBitmap *freeMap, int fileSize)
     }
     while(allocated != 0)
     {
-	Indirect * singleIndirect = new Indirect();
-	
-	if(doubleIndirect->dataSectors[currentIndirect] <= 0)
-	{
+	if(currentIndirect >= doubleIndirect->numSectors)
+	{				// past the last one: add one
+	    Indirect *singleIndirect = new Indirect();
 	    int indSector = freeMap->FindAndSet();
-	    singleIndirect->numSectors = 0;
+
+	    ASSERT(doubleIndirect->numSectors < NumIndirect);
 	    doubleIndirect->dataSectors[doubleIndirect->numSectors++] = indSector;
 	    WriteBack(doubleIndirectSector, (char*) doubleIndirect);
 	    WriteBack(indSector, (char*) singleIndirect);
-	}
-	else
-	{
-	    FetchFrom(doubleIndirect->dataSectors[currentIndirect], (char*)singleIndirect);
+	    delete singleIndirect;
 	}
 	
 	int start = (NumDirect * SectorSize) + (NumIndirect * SectorSize) + (currentIndirect * (NumIndirect *SectorSize));
 	
 	allocated = AllocateIndirectSpace(freeMap, fileSize, start, doubleIndirect->dataSectors[currentIndirect]);
+	if (allocated != 0)
+	    currentIndirect++;		// this block is full, go on to the next
     }    
+    delete doubleIndirect;
 }
 void 
 FileHeader::SetSector(int sector)
@@ -247,6 +249,7 @@ void
 FileHeader::FetchFrom(int sector)
 {
     kernel->synchDisk->ReadSector(sector, (char *)this);
+    cachedSector[0] = cachedSector[1] = -1;	// belonged to another file
 }
 
 void 
@@ -272,6 +275,31 @@ void
 FileHeader::WriteBack(int sector, char* data)
 {
     kernel->synchDisk->WriteSector(sector, data);
+    for (int i = 0; i < 2; i++)
+	if (cachedSector[i] == sector)
+	    cachedSector[i] = -1;
+}
+
+//----------------------------------------------------------------------
+// FileHeader::FetchIndirect
+// 	Return the contents of the indirect block at "sector", reading it
+//	from disk only if it is not the block already cached in "slot".
+//	Sequential access to a file thus reads each indirect block once,
+//	instead of once for every data sector it maps.
+//
+//	"sector" is the disk sector containing the indirect block
+//	"slot" is 0 for the top-level indirect blocks, 1 for the blocks
+//	   under the double indirect block
+//----------------------------------------------------------------------
+
+Indirect *
+FileHeader::FetchIndirect(int sector, int slot)
+{
+    if (cachedSector[slot] != sector) {
+	FetchFrom(sector, cachedBlock[slot]);
+	cachedSector[slot] = sector;
+    }
+    return (Indirect *) cachedBlock[slot];
 }
 
 //----------------------------------------------------------------------
@@ -301,8 +329,7 @@ FileHeader::GetSectorPhysicalAddress(int localSector)
     {
         ASSERT(singleIndirectSector != 0);
         ASSERT(localSector < (NumDirect + NumIndirect));
-        Indirect* singleIndirect = new Indirect;
-        FetchFrom(singleIndirectSector, (char *)singleIndirect);
+        Indirect* singleIndirect = FetchIndirect(singleIndirectSector, 0);
         return singleIndirect->dataSectors[localSector - NumDirect];
     }
     else {
@@ -310,19 +337,131 @@ FileHeader::GetSectorPhysicalAddress(int localSector)
         ASSERT(doubleIndirectSector != 0);
         ASSERT(localSector >= (NumDirect + NumIndirect));
     
-        Indirect* doubleIndirect = new Indirect;
-
-        FetchFrom(doubleIndirectSector, (char *)doubleIndirect);
+        Indirect* doubleIndirect = FetchIndirect(doubleIndirectSector, 0);
     
         int single = (localSector - (NumDirect + NumIndirect))/NumIndirect;
 
-        Indirect* ind = new Indirect;
-        FetchFrom(doubleIndirect->dataSectors[single], (char *)ind);
+        Indirect* ind = FetchIndirect(doubleIndirect->dataSectors[single], 1);
         int pos = (localSector - (NumDirect + NumIndirect)) % NumIndirect;
 
         return ind->dataSectors[pos];
     }
 }
+
+//----------------------------------------------------------------------
+// FileHeader::SectorsFor
+// 	Return how many sectors a new file of "fileSize" bytes occupies:
+//	its header, its data blocks, and the indirect blocks Allocate
+//	creates to map them.
+//----------------------------------------------------------------------
+
+int
+FileHeader::SectorsFor(int fileSize)
+{
+    int data = divRoundUp(fileSize, SectorSize);
+    int count = 1 + data;
+
+    if (data > (int) NumDirect)
+	count++;			// single indirect block
+    if (data > (int) (NumDirect + NumIndirect))
+	count += 1 + divRoundUp(data - (NumDirect + NumIndirect), NumIndirect);
+    return count;
+}
+
+//----------------------------------------------------------------------
+// FileHeader::GetLayout
+// 	Fill "sectors" with every sector the file uses besides its header,
+//	in the order Allocate hands them out: the direct data blocks, the
+//	single indirect block and the data it maps, then the double
+//	indirect block, each block under it, and the data that block maps.
+//	A file laid out by Allocate on an empty disk lists consecutive
+//	sector numbers.
+//
+//	"sectors" must have room for SectorsFor(FileLength()) - 1 entries.
+//	Return the number of entries filled in.
+//----------------------------------------------------------------------
+
+int
+FileHeader::GetLayout(int *sectors)
+{
+    int count = 0, i, j;
+
+    for (i = 0; i < numSectors && i < (int) NumDirect; i++)
+	sectors[count++] = dataSectors[i];
+    if (numSectors > (int) NumDirect) {
+	Indirect *single = FetchIndirect(singleIndirectSector, 0);
+	sectors[count++] = singleIndirectSector;
+	for (i = 0; i < single->numSectors; i++)
+	    sectors[count++] = single->dataSectors[i];
+    }
+    if (numSectors > (int) (NumDirect + NumIndirect)) {
+	Indirect *doubleIndirect = FetchIndirect(doubleIndirectSector, 0);
+	sectors[count++] = doubleIndirectSector;
+	for (j = 0; j < doubleIndirect->numSectors; j++) {
+	    Indirect *ind = FetchIndirect(doubleIndirect->dataSectors[j], 1);
+	    sectors[count++] = doubleIndirect->dataSectors[j];
+	    for (i = 0; i < ind->numSectors; i++)
+		sectors[count++] = ind->dataSectors[i];
+	}
+    }
+    return count;
+}
+
+//----------------------------------------------------------------------
+// FileHeader::MoveTo
+// 	Relocate the file's data and indirect blocks to the sectors
+//	starting at "start", in GetLayout order, so that afterwards the
+//	file occupies one contiguous run.  Data is copied and the new
+//	indirect blocks are written before this returns; only the
+//	in-core header points at the new run.
+//
+//	The caller must have marked the run as in use, and must write
+//	the header back (which switches the file over in a single sector
+//	write) before freeing the old sectors.  Until then the old copy
+//	on disk is still complete.
+//----------------------------------------------------------------------
+
+void
+FileHeader::MoveTo(int start)
+{
+    int next = start, i, j;
+    char *data = new char[SectorSize];
+    Indirect single, doubleIndirect, ind;
+
+    for (i = 0; i < numSectors && i < (int) NumDirect; i++) {
+	kernel->synchDisk->ReadSector(dataSectors[i], data);
+	dataSectors[i] = next++;
+	kernel->synchDisk->WriteSector(dataSectors[i], data);
+    }
+    if (numSectors > (int) NumDirect) {
+	single = *FetchIndirect(singleIndirectSector, 0);
+	singleIndirectSector = next++;
+	for (i = 0; i < single.numSectors; i++) {
+	    kernel->synchDisk->ReadSector(single.dataSectors[i], data);
+	    single.dataSectors[i] = next++;
+	    kernel->synchDisk->WriteSector(single.dataSectors[i], data);
+	}
+	WriteBack(singleIndirectSector, (char *) &single);
+    }
+    if (numSectors > (int) (NumDirect + NumIndirect)) {
+	doubleIndirect = *FetchIndirect(doubleIndirectSector, 0);
+	doubleIndirectSector = next++;
+	for (j = 0; j < doubleIndirect.numSectors; j++) {
+	    ind = *FetchIndirect(doubleIndirect.dataSectors[j], 1);
+	    doubleIndirect.dataSectors[j] = next++;
+	    for (i = 0; i < ind.numSectors; i++) {
+		kernel->synchDisk->ReadSector(ind.dataSectors[i], data);
+		ind.dataSectors[i] = next++;
+		kernel->synchDisk->WriteSector(ind.dataSectors[i], data);
+	    }
+	    WriteBack(doubleIndirect.dataSectors[j], (char *) &ind);
+	}
+	WriteBack(doubleIndirectSector, (char *) &doubleIndirect);
+    }
+    cachedSector[0] = cachedSector[1] = -1;
+    delete [] data;
+}
+
 //----------------------------------------------------------------------
 // FileHeader::FileLength
 // 	Return the number of bytes in the file.
@@ -36,6 +36,8 @@
 // by allocating blocks for the file (if it is a new file), or by
 // reading it from disk.
 
+class Indirect;
+
 class FileHeader {
   public:
 	// MP4 mod tag
@@ -64,6 +66,18 @@ class FileHeader {
     void Print();			// Print the contents of the file.
 
 
+    static int SectorsFor(int fileSize);	// Number of sectors (header, data
+					// and indirect blocks) Allocate
+					// will take for a new file
+
+    int GetLayout(int *sectors);	// List the data and indirect block
+					// sectors in allocation order;
+					// return how many there are
+    void MoveTo(int start);		// Copy the data and indirect blocks
+					// to the free run beginning at
+					// "start"; the caller writes the
+					// header back and frees the old ones
+
     int GetSectorPhysicalAddress(int i);
     void SetSector(int sector);
     int GetSector();
@@ -85,7 +99,9 @@ class FileHeader {
 		
 		Disk Part - numBytes, numSectors, dataSectors occupy exactly 128 bytes and will be
 		written to a sector on disk.
-		In-core part - none
+		In-core part - the most recently fetched indirect blocks, so that
+		walking a file sector by sector does not re-read them from disk
+		for every data sector.
 		
 	*/
     int headSector;
@@ -96,12 +112,22 @@ class FileHeader {
     int numSectors;			// Number of data sectors in the file
     int dataSectors[NumDirect];		// Disk sector numbers for each data 
 					// block in the file
+
+    // In-core part: must stay after the disk part.  Slot 0 caches the
+    // single or double indirect block, slot 1 a block under the double
+    // indirect block.
+    int cachedSector[2];		// Sector held in each slot, or -1
+    char cachedBlock[2][SectorSize];	// Contents of that sector
+
+    Indirect *FetchIndirect(int sector, int slot);
+					// Read an indirect block through
+					// the cache
 };
 
 class Indirect
 {
   public:
-    Indirect(){numSectors = 0; memset(dataSectors, (int)0, NumIndirect);}
+    Indirect(){numSectors = 0; memset(dataSectors, 0, sizeof(dataSectors));}
     int numSectors;
     int dataSectors[NumIndirect];
 };
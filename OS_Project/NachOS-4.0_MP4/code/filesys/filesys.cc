@@ -51,6 +51,7 @@
 #include "directory.h"
 #include "filehdr.h"
 #include "filesys.h"
+#include "main.h"
 
 // Sectors containing the file headers for the bitmap of free sectors,
 // and the directory of files.  These file headers are placed in well-known
@@ -63,7 +64,7 @@
 // of files that can be loaded onto the disk.
 #define FreeMapFileSize 	(NumSectors / BitsInByte)
 #define NumDirEntries 		63
-#define DirectoryFileSize 	(sizeof(DirectoryEntry) * NumDirEntries)
+#define DirectoryFileSize 	(sizeof(DirectoryEntry) * NumDirEntries + NameHeapSize)
 
 //----------------------------------------------------------------------
 // FileSystem::FileSystem
@@ -252,6 +253,9 @@ FileSystem::Create(char *name, int initialSize, bool dirMode)
       success = FALSE;			// file is already in directory
     else {
         freeMap = new PersistentBitmap(freeMapFile,NumSectors);
+	// keep the header, data and indirect blocks in one run if we can
+	freeMap->ReserveRun(FileHeader::SectorsFor(dirMode ? DirectoryFileSize
+							   : initialSize));
         sector = freeMap->FindAndSet();	// find a sector to hold the file header
     	if (sector == -1)
             success = FALSE;		// no free block for file header
@@ -404,8 +408,8 @@ FileSystem::Remove(char *name,bool recursive)
     {
         for (int i = 0; i < directory->getTableSize(); ++i) {
             if (directory->getTable()[i].inUse) {
-                //printf("go in %s\n",directory->getTable()[i].name);
-                if(0 == strcmp(localName,directory->getTable()[i].name))//find index
+                //printf("go in %s\n",directory->GetNameWithId(i));
+                if(0 == strcmp(localName,directory->GetNameWithId(i)))//find index
                 {//printf("match!\n");
                     if(directory->getTable()[i].dir)
                     {
@@ -414,14 +418,14 @@ FileSystem::Remove(char *name,bool recursive)
                         nextdirectory->FetchFrom(nextdirFile);
                         for(int k = 0; k < nextdirectory->getTableSize();k++)
                             if(nextdirectory->getTable()[k].inUse){
-                           //printf("go go in %s\n",nextdirectory->getTable()[k].name);
-                            nextdirectory->Remove(nextdirectory->getTable()[k].name,true);
+                           //printf("go go in %s\n",nextdirectory->GetNameWithId(k));
+                            nextdirectory->Remove(nextdirectory->GetNameWithId(k),true);
                         }
                         delete nextdirectory;
                         delete nextdirFile;
                     }
                     else
-                        Remove(directory->getTable()[i].name,false);
+                        Remove(directory->GetNameWithId(i),false);
                     break;
                 }
             }
@@ -474,11 +478,11 @@ FileSystem::List(char *list, bool recursive)
         {
             if(directory->getTable()[k].inUse)
             {
-                if(0 == strcmp(list,directory->getTable()[k].name))
+                if(0 == strcmp(list,directory->GetNameWithId(k)))
                 {
                     if(false == directory->getTable()[k].dir)
                     {
-                        printf("[%d] %s F\n", k,  directory->getTable()[k].name);
+                        printf("[%d] %s F\n", k,  directory->GetNameWithId(k));
                         printf("[Warning]this is a file\n");
                         delete directory;
                         return ;
@@ -538,6 +542,196 @@ FileSystem::Print()
     delete directory;
 }
 
+//----------------------------------------------------------------------
+// CountExtents
+// 	Return the number of contiguous runs ("extents") in a file whose
+//	header is at sector "header" and whose other sectors, in
+//	allocation order, are "sectors".  A file that can be read
+//	without seeking has one extent.
+//----------------------------------------------------------------------
+
+static int
+CountExtents(int header, int *sectors, int count)
+{
+    int extents = 1, prev = header;
+
+    for (int i = 0; i < count; i++) {
+	if (sectors[i] != prev + 1)
+	    extents++;
+	prev = sectors[i];
+    }
+    return extents;
+}
+
+//----------------------------------------------------------------------
+// FileSystem::CollectFiles
+// 	Mark in "headers" the header sector of every file and directory
+//	found under the directory whose header is at "dirSector",
+//	descending into subdirectories.
+//----------------------------------------------------------------------
+
+void
+FileSystem::CollectFiles(int dirSector, Bitmap *headers)
+{
+    Directory *directory = new Directory(NumDirEntries);
+    OpenFile *dirFile = new OpenFile(dirSector);
+    DirectoryEntry *table = directory->getTable();
+
+    directory->FetchFrom(dirFile);
+    for (int i = 0; i < directory->getTableSize(); i++) {
+	if (table[i].inUse) {
+	    headers->Mark(table[i].sector);
+	    if (table[i].dir)
+		CollectFiles(table[i].sector, headers);
+	}
+    }
+    delete dirFile;
+    delete directory;
+}
+
+//----------------------------------------------------------------------
+// FileSystem::DefragmentFile
+// 	Move the data and indirect blocks of the file whose header is at
+//	"sector" into one free run, preferably right behind the header.
+//	Nothing is done unless the move lowers the number of extents.
+//
+//	The steps are ordered so that the disk is consistent after each
+//	one: the new run is marked in use on disk first, the data is
+//	copied, the header is rewritten to point at the copy (a single
+//	sector write), and only then are the old sectors freed.
+//
+//	Return TRUE if the file was moved.
+//----------------------------------------------------------------------
+
+bool
+FileSystem::DefragmentFile(int sector, PersistentBitmap *freeMap)
+{
+    FileHeader *hdr = new FileHeader;
+    int *layout, count, start, i, n;
+    bool moved = FALSE;
+
+    hdr->FetchFrom(sector);
+    count = FileHeader::SectorsFor(hdr->FileLength()) - 1;
+    if (count > 0) {
+	layout = new int[count];
+	n = hdr->GetLayout(layout);
+	ASSERT(n == count);
+
+	start = freeMap->FindRun(count, sector + 1);
+	if (start < 0)
+	    start = freeMap->FindRun(count, 0);
+	if (start >= 0 && ((start == sector + 1) ? 1 : 2) <
+				CountExtents(sector, layout, count)) {
+	    DEBUG(dbgFile, "Moving file at sector " << sector << " to " << start);
+	    for (i = 0; i < count; i++)
+		freeMap->Mark(start + i);
+	    freeMap->WriteBack(freeMapFile);
+	    hdr->MoveTo(start);
+	    hdr->WriteBack(sector);
+	    for (i = 0; i < count; i++)
+		freeMap->Clear(layout[i]);
+	    freeMap->WriteBack(freeMapFile);
+	    moved = TRUE;
+	}
+	delete [] layout;
+    }
+    delete hdr;
+    return moved;
+}
+
+//----------------------------------------------------------------------
+// FileSystem::Defragment
+// 	Relocate fragmented files so that each occupies a contiguous run
+//	of sectors.  Files that are already contiguous are skipped, so
+//	calling this repeatedly with a small "maxFiles" defragments the
+//	disk a few files at a time.
+//
+//	Nothing is moved while a file is open, since its in-core header
+//	would still point at the old sectors.  The bitmap and root
+//	directory files stay where format put them.
+//
+//	"maxFiles" -- most files to move in this call, or 0 for no limit
+//----------------------------------------------------------------------
+
+int
+FileSystem::Defragment(int maxFiles)
+{
+    Bitmap *headers;
+    PersistentBitmap *freeMap;
+    int moved = 0;
+
+    if (currentOpenFile != NULL) {
+	DEBUG(dbgFile, "Not defragmenting, a file is open");
+	return 0;
+    }
+    headers = new Bitmap(NumSectors);
+    CollectFiles(DirectorySector, headers);
+    freeMap = new PersistentBitmap(freeMapFile, NumSectors);
+    for (int i = 0; i < NumSectors && (maxFiles <= 0 || moved < maxFiles); i++) {
+	if (headers->Test(i) && DefragmentFile(i, freeMap))
+	    moved++;
+    }
+    delete freeMap;
+    delete headers;
+    return moved;
+}
+
+//----------------------------------------------------------------------
+// FileSystem::PrintFragmentation
+// 	Print the number of files, their total number of extents, how
+//	many are fragmented, and the simulated time it takes to read
+//	every file from start to end.
+//----------------------------------------------------------------------
+
+void
+FileSystem::PrintFragmentation()
+{
+    Bitmap *headers = new Bitmap(NumSectors);
+    FileHeader *hdr = new FileHeader;
+    OpenFile *openFile;
+    int numFiles = 0, numExtents = 0, numFragmented = 0;
+    int *layout, count, extents, length, startTicks, i;
+    char *buffer;
+
+    CollectFiles(DirectorySector, headers);
+
+    for (i = 0; i < NumSectors; i++) {
+	if (!headers->Test(i))
+	    continue;
+	hdr->FetchFrom(i);
+	layout = new int[FileHeader::SectorsFor(hdr->FileLength())];
+	count = hdr->GetLayout(layout);
+	extents = CountExtents(i, layout, count);
+	numFiles++;
+	numExtents += extents;
+	if (extents > 1)
+	    numFragmented++;
+	delete [] layout;
+    }
+
+    // time the reads separately, so the header walk above is not counted
+    startTicks = kernel->stats->totalTicks;
+    for (i = 0; i < NumSectors; i++) {
+	if (!headers->Test(i))
+	    continue;
+	openFile = new OpenFile(i);
+	length = openFile->Length();
+	if (length > 0) {
+	    buffer = new char[length];
+	    openFile->ReadAt(buffer, length, 0);
+	    delete [] buffer;
+	}
+	delete openFile;
+    }
+
+    printf("Files: %d, extents: %d, fragmented files: %d\n",
+			numFiles, numExtents, numFragmented);
+    printf("Sequential read of all files: %d ticks\n",
+			kernel->stats->totalTicks - startTicks);
+    delete hdr;
+    delete headers;
+}
+
 int FileSystem::Close(int id)
 {
     if(currentFileId != id)
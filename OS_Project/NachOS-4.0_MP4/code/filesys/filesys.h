@@ -66,6 +66,9 @@ class FileSystem {
 };
 
 #else // FILESYS
+class Bitmap;
+class PersistentBitmap;
+
 class FileSystem {
   public:
     FileSystem(bool format);		// Initialize the file system.
@@ -92,8 +95,20 @@ class FileSystem {
     void List(char *list, bool recursive);			// List all the files in the file system
 
     void Print();			// List all the files and their contents
+
+    int Defragment(int maxFiles);	// Move up to "maxFiles" fragmented
+					// files (0 = all) into contiguous
+					// runs; return how many were moved
+    void PrintFragmentation();		// Report how scattered the files
+					// are, and how long reading them
+					// all sequentially takes
   
   private:
+   void CollectFiles(int dirSector, Bitmap *headers);
+					// Mark the header sector of every file
+					// and directory under "dirSector"
+   bool DefragmentFile(int sector, PersistentBitmap *freeMap);
+
    OpenFile* freeMapFile;		// Bit map of free disk blocks,
 					// represented as a file
    OpenFile* directoryFile;		// "Root" directory -- list of 
@@ -98,13 +98,14 @@ OpenFile::Write(char *into, int numBytes)
 //	sector at a time.  Thus:
 //
 //	For ReadAt:
-//	   We read in all of the full or partial sectors that are part of the
-//	   request, but we only copy the part we are interested in.
+//	   Full sectors are read directly into the caller's buffer.  Partial
+//	   sectors are read into a temporary sector buffer, and we only copy
+//	   the part we are interested in.
 //	For WriteAt:
+//	   Full sectors are written directly from the caller's buffer.
 //	   We must first read in any sectors that will be partially written,
 //	   so that we don't overwrite the unmodified portion.  We then copy
-//	   in the data that will be modified, and write back all the full
-//	   or partial sectors that are part of the request.
+//	   in the data that will be modified, and write the sector back.
 //
 //	"into" -- the buffer to contain the data to be read from disk 
 //	"from" -- the buffer containing the data to be written to disk 
@@ -117,8 +118,8 @@ int
 OpenFile::ReadAt(char *into, int numBytes, int position)
 {
     int fileLength = hdr->FileLength();
-    int i, firstSector, lastSector, numSectors;
-    char *buf;
+    int i, firstSector, lastSector, start, end;
+    char *buf = NULL;
 
     if ((numBytes <= 0) || (position >= fileLength))
     	return 0; 				// check request
@@ -128,17 +129,26 @@ OpenFile::ReadAt(char *into, int numBytes, int position)
 
     firstSector = divRoundDown(position, SectorSize);
     lastSector = divRoundDown(position + numBytes - 1, SectorSize);
-    numSectors = 1 + lastSector - firstSector;
 
-    // read in all the full and partial sectors that we need
-    buf = new char[numSectors * SectorSize];
-    for (i = firstSector; i <= lastSector; i++)	
-        kernel->synchDisk->ReadSector(hdr->ByteToSector(i * SectorSize), 
-					&buf[(i - firstSector) * SectorSize]);
-
-    // copy the part we want
-    bcopy(&buf[position - (firstSector * SectorSize)], into, numBytes);
-    delete [] buf;
+    // Sectors that lie entirely inside the request are transferred
+    // straight into the caller's buffer.  Only a partial first or last
+    // sector needs to go through a (single sector) bounce buffer.
+    for (i = firstSector; i <= lastSector; i++) {
+	start = max(position, i * SectorSize);
+	end = min(position + numBytes, (i + 1) * SectorSize);
+	if ((start == i * SectorSize) && (end == (i + 1) * SectorSize)) {
+	    kernel->synchDisk->ReadSector(hdr->ByteToSector(i * SectorSize),
+					&into[start - position]);
+	} else {
+	    if (buf == NULL)
+		buf = new char[SectorSize];
+	    kernel->synchDisk->ReadSector(hdr->ByteToSector(i * SectorSize), buf);
+	    bcopy(&buf[start - (i * SectorSize)], &into[start - position],
+							end - start);
+	}
+    }
+    if (buf != NULL)
+	delete [] buf;
     return numBytes;
 }
 
@@ -146,9 +156,8 @@ int
 OpenFile::WriteAt(char *from, int numBytes, int position)
 {
     int fileLength = hdr->FileLength();
-    int i, firstSector, lastSector, numSectors;
-    bool firstAligned, lastAligned;
-    char *buf;
+    int i, firstSector, lastSector, start, end;
+    char *buf = NULL;
 
     if ((numBytes <= 0) || (position >= fileLength))
 	return 0;				// check request
@@ -158,28 +167,28 @@ OpenFile::WriteAt(char *from, int numBytes, int position)
 
     firstSector = divRoundDown(position, SectorSize);
     lastSector = divRoundDown(position + numBytes - 1, SectorSize);
-    numSectors = 1 + lastSector - firstSector;
-    buf = new char[numSectors * SectorSize];
-	
-	// Mp4 mod tag
-	memset(buf, 0, sizeof(char) * numSectors * SectorSize); // dummy operation to keep valgrind happy
-
-    firstAligned = (position == (firstSector * SectorSize));
-    lastAligned = ((position + numBytes) == ((lastSector + 1) * SectorSize));
-
-      ReadAt(buf, SectorSize, firstSector * SectorSize);	
-    if (!lastAligned && ((firstSector != lastSector) || firstAligned))
-        ReadAt(&buf[(lastSector - firstSector) * SectorSize], 
-				SectorSize, lastSector * SectorSize);	
-
-// copy in the bytes we want to change 
-    bcopy(from, &buf[position - (firstSector * SectorSize)], numBytes);
-
-// write modified sectors back
-    for (i = firstSector; i <= lastSector; i++)	
-        kernel->synchDisk->WriteSector(hdr->ByteToSector(i * SectorSize), 
-					&buf[(i - firstSector) * SectorSize]);
-    delete [] buf;
+
+    // Sectors that are overwritten completely go to disk straight from
+    // the caller's buffer; only a partial first or last sector has to
+    // be read in first, so that we don't overwrite the unmodified part.
+    for (i = firstSector; i <= lastSector; i++) {
+	start = max(position, i * SectorSize);
+	end = min(position + numBytes, (i + 1) * SectorSize);
+	if ((start == i * SectorSize) && (end == (i + 1) * SectorSize)) {
+	    kernel->synchDisk->WriteSector(hdr->ByteToSector(i * SectorSize),
+					&from[start - position]);
+	} else {
+	    if (buf == NULL)
+		buf = new char[SectorSize];
+	    memset(buf, 0, SectorSize);	// part past EOF is not read
+	    ReadAt(buf, SectorSize, i * SectorSize);
+	    bcopy(&from[start - position], &buf[start - (i * SectorSize)],
+							end - start);
+	    kernel->synchDisk->WriteSector(hdr->ByteToSector(i * SectorSize), buf);
+	}
+    }
+    if (buf != NULL)
+	delete [] buf;
     return numBytes;
 }
 
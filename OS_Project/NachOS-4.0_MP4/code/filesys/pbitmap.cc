@@ -21,6 +21,7 @@
 
 PersistentBitmap::PersistentBitmap(int numItems):Bitmap(numItems) 
 { 
+    runNext = runEnd = 0;
 }
 
 //----------------------------------------------------------------------
@@ -41,6 +42,7 @@ PersistentBitmap::PersistentBitmap(OpenFile *file, int numItems):Bitmap(numItems
     // but we will just overwrite that with the contents of the
     // map found in the file
     file->ReadAt((char *)map, numWords * sizeof(unsigned), 0);
+    runNext = runEnd = 0;
 }
 
 //----------------------------------------------------------------------
@@ -77,3 +79,74 @@ PersistentBitmap::WriteBack(OpenFile *file)
 {
    file->WriteAt((char *)map, numWords * sizeof(unsigned), 0);
 }
+
+//----------------------------------------------------------------------
+// PersistentBitmap::FindRun
+// 	Return the number of the first bit of a run of "count"
+//	consecutive clear bits, looking only at bits numbered "from"
+//	or higher.  The bits are not set.
+//
+//	If there is no such run, return -1.
+//----------------------------------------------------------------------
+
+int
+PersistentBitmap::FindRun(int count, int from)
+{
+    int start = from;
+
+    if (count <= 0)
+	return -1;
+    for (int i = from; i < numBits; i++) {
+	if (Test(i)) {
+	    start = i + 1;
+	} else if (i - start + 1 == count) {
+	    return start;
+	}
+    }
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// PersistentBitmap::ReserveRun
+// 	Look for the first run of "count" consecutive clear bits, and
+//	make the following calls to FindAndSet hand out that run in
+//	order.  This keeps a file's sectors contiguous on disk, so
+//	that reading or writing it sequentially needs no seeks.
+//
+//	Return FALSE if there is no such run; allocation then falls
+//	back to first-fit, one sector at a time.
+//
+//	"count" is the number of sectors that will be allocated
+//----------------------------------------------------------------------
+
+bool
+PersistentBitmap::ReserveRun(int count)
+{
+    int start = FindRun(count, 0);
+
+    runNext = runEnd = 0;
+    if (start < 0)
+	return FALSE;
+    runNext = start;
+    runEnd = start + count;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// PersistentBitmap::FindAndSet
+// 	Allocate a sector: the next one of the run set aside by
+//	ReserveRun if there is one left, otherwise the first clear bit.
+//
+//	If no bits are clear, return -1.
+//----------------------------------------------------------------------
+
+int
+PersistentBitmap::FindAndSet()
+{
+    if (runNext < runEnd && !Test(runNext)) {
+	Mark(runNext);
+	return runNext++;
+    }
+    runNext = runEnd = 0;
+    return Bitmap::FindAndSet();
+}
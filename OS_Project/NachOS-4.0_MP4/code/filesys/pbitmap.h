@@ -30,6 +30,18 @@ class PersistentBitmap : public Bitmap {
 
     void FetchFrom(OpenFile *file);     // read bitmap from the disk
     void WriteBack(OpenFile *file); 	// write bitmap contents to disk 
+
+    int FindRun(int count, int from);	// first run of "count" clear bits
+					// starting at or after "from"
+    bool ReserveRun(int count);		// steer the following allocations
+					// to a run of "count" free sectors
+    int FindAndSet();			// allocate the next sector of the
+					// reserved run, or the first clear
+					// bit if there is none
+
+  private:
+    int runNext;			// next sector of the reserved run
+    int runEnd;				// one past the end of the run
 };
 
 #endif // PBITMAP_H
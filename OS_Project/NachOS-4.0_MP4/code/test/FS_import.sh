@@ -0,0 +1,15 @@
+seq -w 1 10000 > num_10000.txt
+size=`wc -c < num_10000.txt`
+../build.linux/nachos -f
+../build.linux/nachos -cpb num_10000.txt /10000
+../build.linux/nachos -p /10000 | head -c $size | cmp - num_10000.txt && echo "import of a $size byte file: OK"
+echo "========================================="
+mkdir -p import_tree/sub
+cp num_10000.txt import_tree/a
+cp num_100.txt import_tree/sub/b
+../build.linux/nachos -f
+../build.linux/nachos -cpr import_tree /
+../build.linux/nachos -p /a | head -c $size | cmp - num_10000.txt && echo "import of a tree: OK"
+../build.linux/nachos -lr /
+echo "========================================="
+rm -rf import_tree num_10000.txt
@@ -5,7 +5,8 @@
 // Usage: nachos -d <debugflags> -rs <random seed #>
 //              -s -x <nachos file> -ci <consoleIn> -co <consoleOut>
 //              -f -cp <unix file> <nachos file>
-//              -p <nachos file> -r <nachos file> -l -D
+//              -cpb <unix file> <nachos file> -cpr <unix dir> <nachos dir>
+//              -p <nachos file> -r <nachos file> -l -D -defrag
 //              -n <network reliability> -m <machine id>
 //              -z -K -C -N
 //
@@ -25,10 +26,13 @@
 //    Filesystem-related flags:
 //    -f forces the Nachos disk to be formatted
 //    -cp copies a file from UNIX to Nachos
+//    -cpb copies a file from UNIX to Nachos in large batches (bulk import)
+//    -cpr imports a UNIX directory tree into a Nachos directory
 //    -p prints a Nachos file to stdout
 //    -r removes a Nachos file from the file system
 //    -l lists the contents of the Nachos directory
 //    -D prints the contents of the entire file system
+//    -defrag moves every file into a contiguous run of sectors
 //
 //  Note: the file system flags are not used if the stub filesystem
 //        is being used
@@ -44,8 +48,12 @@
 #include "main.h"
 #include "filesys.h"
 #include "openfile.h"
+#include "disk.h"
 #include "sysdep.h"
 #include <cstring>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/time.h>
 // global variables
 Kernel *kernel;
 Debug *debug;
@@ -70,6 +78,13 @@ Cleanup(int x)
 //-------------------------------------------------------------------
 static const int TransferSize = 128;
 
+//-------------------------------------------------------------------
+// Constant used by "Import"
+//   The number of bytes moved per read/write when bulk importing;
+//   each write hands OpenFile a whole run of sectors at once.
+//-------------------------------------------------------------------
+static const int ImportTransferSize = 64 * SectorSize;
+
 
 #ifndef FILESYS_STUB
 //----------------------------------------------------------------------
@@ -118,6 +133,152 @@ Copy(char *from, char *to)
     Close(fd);
 }
 
+//----------------------------------------------------------------------
+// Import
+//      Bulk version of Copy: copy the UNIX file "from" to the Nachos
+//	file "to" in ImportTransferSize batches.  The file's sectors are
+//	allocated as one contiguous run when the disk has one, so each
+//	batch is written with no seeks in between.
+//
+//	Return the number of bytes copied, or -1 on failure.
+//----------------------------------------------------------------------
+
+static int
+Import(char *from, char *to)
+{
+    int fd;
+    OpenFile* openFile;
+    int amountRead, fileLength, copied = 0;
+    char *buffer;
+
+    if ((fd = OpenForReadWrite(from,FALSE)) < 0) {
+        printf("Import: couldn't open input file %s\n", from);
+        return -1;
+    }
+
+    Lseek(fd, 0, 2);
+    fileLength = Tell(fd);
+    Lseek(fd, 0, 0);
+
+    DEBUG(dbgFile, "Importing file " << from << " of size " << fileLength <<  " to file " << to);
+    if (!kernel->fileSystem->Create(to, fileLength)) {
+        printf("Import: couldn't create output file %s\n", to);
+        Close(fd);
+        return -1;
+    }
+
+    openFile = kernel->fileSystem->Open(to);
+    ASSERT(openFile != NULL);
+
+    buffer = new char[ImportTransferSize];
+    while ((amountRead=ReadPartial(fd, buffer, ImportTransferSize)) > 0)
+        copied += openFile->Write(buffer, amountRead);
+    delete [] buffer;
+
+    delete openFile;
+    Close(fd);
+    return copied;
+}
+
+//----------------------------------------------------------------------
+// ImportTree
+//      Import every file under the UNIX directory "from" into the
+//	Nachos directory "to", creating Nachos directories for UNIX
+//	subdirectories.  Hidden entries (starting with '.') are skipped,
+//	and so are entries whose full name is too long.
+//
+//	Return the number of bytes copied; "numFiles" is incremented
+//	for each file imported.
+//----------------------------------------------------------------------
+
+static int
+ImportTree(char *from, char *to, int *numFiles)
+{
+    DIR *dir;
+    struct dirent *entry;
+    struct stat info;
+    char unixName[256], nachosName[256];
+    int copied, numBytes = 0;
+
+    if ((dir = opendir(from)) == NULL) {
+        printf("Import: couldn't open input directory %s\n", from);
+        return 0;
+    }
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.')
+            continue;
+        if (snprintf(unixName, sizeof(unixName), "%s/%s", from,
+                     entry->d_name) >= (int) sizeof(unixName)
+            || snprintf(nachosName, sizeof(nachosName), "%s/%s",
+                        (strcmp(to, "/") == 0) ? "" : to,
+                        entry->d_name) >= (int) sizeof(nachosName)) {
+            printf("Import: name too long, skipping %s/%s\n", from,
+                   entry->d_name);
+            continue;
+        }
+        if (stat(unixName, &info) < 0)
+            continue;
+        if (S_ISDIR(info.st_mode)) {
+            if (!kernel->fileSystem->Create(nachosName, 0, true)) {
+                printf("Import: couldn't create directory %s\n", nachosName);
+                continue;
+            }
+            numBytes += ImportTree(unixName, nachosName, numFiles);
+        } else if ((copied = Import(unixName, nachosName)) >= 0) {
+            numBytes += copied;
+            (*numFiles)++;
+        }
+    }
+    closedir(dir);
+    return numBytes;
+}
+
+//----------------------------------------------------------------------
+// ImportAll
+//      Run a bulk import and report its throughput, both in simulated
+//	time (disk ticks) and in host wall-clock time.
+//
+//	"from"/"to" are the UNIX and Nachos names; if "tree" is set they
+//	are directories and the whole tree is imported.
+//----------------------------------------------------------------------
+
+static void
+ImportAll(char *from, char *to, bool tree)
+{
+    int numFiles = 0, numBytes;
+    int startTicks = kernel->stats->totalTicks;
+    int startWrites = kernel->stats->numDiskWrites;
+    int startReads = kernel->stats->numDiskReads;
+    struct timeval start, end;
+    double seconds;
+    int ticks;
+
+    gettimeofday(&start, NULL);
+    if (tree) {
+        if (strcmp(to, "/") != 0)
+            kernel->fileSystem->Create(to, 0, true);	// may already exist
+        numBytes = ImportTree(from, to, &numFiles);
+    } else if ((numBytes = Import(from, to)) >= 0) {
+        numFiles = 1;
+    } else {
+        numBytes = 0;
+    }
+    gettimeofday(&end, NULL);
+
+    ticks = kernel->stats->totalTicks - startTicks;
+    seconds = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+    printf("Imported %d files, %d bytes\n", numFiles, numBytes);
+    printf("Disk I/O: %d writes, %d reads, %d ticks",
+           kernel->stats->numDiskWrites - startWrites,
+           kernel->stats->numDiskReads - startReads, ticks);
+    if (ticks > 0)
+        printf(" (%.1f bytes per 1000 ticks)", numBytes * 1000.0 / ticks);
+    printf("\nHost time: %.3f seconds", seconds);
+    if (seconds > 0)
+        printf(" (%.1f KB/s)", numBytes / 1024.0 / seconds);
+    printf("\n");
+}
+
 #endif // FILESYS_STUB
 
 //----------------------------------------------------------------------
@@ -192,10 +353,14 @@ main(int argc, char **argv)
 #ifndef FILESYS_STUB
     char *copyUnixFileName = NULL;    // UNIX file to be copied into Nachos
     char *copyNachosFileName = NULL;  // name of copied file in Nachos
+    char *importUnixName = NULL;      // UNIX file or directory to import
+    char *importNachosName = NULL;    // where to put it in Nachos
+    bool importTreeFlag = false;
     char *printFileName = NULL;
     char *removeFileName = NULL;
     bool dirListFlag = false;
     bool dumpFlag = false;
+    bool defragFlag = false;
 	// MP4 mod tag
 	char *createDirectoryName = NULL;
 	char *listDirectoryName = NULL;
@@ -237,6 +402,13 @@ main(int argc, char **argv)
 	    copyNachosFileName = argv[i + 2];
 	    i += 2;
 	}
+	else if (strcmp(argv[i], "-cpb") == 0 || strcmp(argv[i], "-cpr") == 0) {
+	    ASSERT(i + 2 < argc);
+	    importUnixName = argv[i + 1];
+	    importNachosName = argv[i + 2];
+	    importTreeFlag = (strcmp(argv[i], "-cpr") == 0);
+	    i += 2;
+	}
 	else if (strcmp(argv[i], "-p") == 0) {
 	    ASSERT(i + 1 < argc);
 	    printFileName = argv[i + 1];
@@ -282,6 +454,9 @@ main(int argc, char **argv)
 	else if (strcmp(argv[i], "-D") == 0) {
 	    dumpFlag = true;
 	}
+	else if (strcmp(argv[i], "-defrag") == 0) {
+	    defragFlag = true;
+	}
 #endif //FILESYS_STUB
 	else if (strcmp(argv[i], "-u") == 0) {
             cout << "Partial usage: nachos [-z -d debugFlags]\n";
@@ -289,8 +464,9 @@ main(int argc, char **argv)
 	    cout << "Partial usage: nachos [-K] [-C] [-N]\n";
 #ifndef FILESYS_STUB
             cout << "Partial usage: nachos [-cp UnixFile NachosFile]\n";
+            cout << "Partial usage: nachos [-cpb UnixFile NachosFile] [-cpr UnixDir NachosDir]\n";
             cout << "Partial usage: nachos [-p fileName] [-r fileName]\n";
-            cout << "Partial usage: nachos [-l] [-D]\n";
+            cout << "Partial usage: nachos [-l] [-D] [-defrag]\n";
 #endif //FILESYS_STUB
 	}
 
@@ -324,6 +500,16 @@ main(int argc, char **argv)
     if (copyUnixFileName != NULL && copyNachosFileName != NULL) {
 		Copy(copyUnixFileName,copyNachosFileName);
     }
+    if (importUnixName != NULL && importNachosName != NULL) {
+		ImportAll(importUnixName, importNachosName, importTreeFlag);
+    }
+    if (defragFlag) {
+		printf("Before defragmenting:\n");
+		kernel->fileSystem->PrintFragmentation();
+		printf("Moved %d files\n", kernel->fileSystem->Defragment(0));
+		printf("After defragmenting:\n");
+		kernel->fileSystem->PrintFragmentation();
+    }
     if (dumpFlag) {
 		kernel->fileSystem->Print();
     }
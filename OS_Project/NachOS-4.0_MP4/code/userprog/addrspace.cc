@@ -311,6 +311,126 @@ AddrSpace::Translate(unsigned int vaddr, unsigned int *paddr, int isReadWrite)
     return NoException;
 }
 
+//----------------------------------------------------------------------
+// AddrSpace::CopyFromUser
+//  Copy "size" bytes starting at user virtual address "vaddr" into
+//  the kernel buffer "into".
+//
+//  Consecutive virtual pages need not be consecutive in physical
+//  memory, so we translate the address once per page and bcopy
+//  the whole span that lies within that page.
+//
+//  Return FALSE if some page in the range could not be translated.
+//----------------------------------------------------------------------
 
+bool
+AddrSpace::CopyFromUser(char *into, unsigned int vaddr, int size)
+{
+    unsigned int paddr;
+    int span;
+
+    while (size > 0) {
+        span = min(size, (int) (PageSize - (vaddr % PageSize)));
+        if (Translate(vaddr, &paddr, 0) != NoException)
+            return FALSE;
+        bcopy(&(kernel->machine->mainMemory[paddr]), into, span);
+        into += span;
+        vaddr += span;
+        size -= span;
+    }
+    return TRUE;
+}
 
+//----------------------------------------------------------------------
+// AddrSpace::CopyToUser
+//  Copy "size" bytes from the kernel buffer "from" to user virtual
+//  address "vaddr", one page-sized span at a time.  The pages
+//  written are marked dirty.
+//
+//  Return FALSE if some page in the range could not be translated,
+//  or is read-only.
+//----------------------------------------------------------------------
 
+bool
+AddrSpace::CopyToUser(unsigned int vaddr, char *from, int size)
+{
+    unsigned int paddr;
+    int span;
+
+    while (size > 0) {
+        span = min(size, (int) (PageSize - (vaddr % PageSize)));
+        if (Translate(vaddr, &paddr, 1) != NoException)
+            return FALSE;
+        bcopy(from, &(kernel->machine->mainMemory[paddr]), span);
+        from += span;
+        vaddr += span;
+        size -= span;
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::CopyStringFromUser
+//  Copy the null-terminated string at user virtual address "vaddr"
+//  into the kernel buffer "into", which holds "maxLen" bytes.
+//  Each page is searched for the terminator with memchr, so the
+//  string is still moved a page-sized span at a time.
+//
+//  Return the length of the string, or -1 if it could not be
+//  translated or does not fit in "maxLen" bytes.
+//----------------------------------------------------------------------
+
+int
+AddrSpace::CopyStringFromUser(char *into, unsigned int vaddr, int maxLen)
+{
+    unsigned int paddr;
+    int span, len = 0;
+    char *src, *end;
+
+    while (len < maxLen) {
+        span = min(maxLen - len, (int) (PageSize - (vaddr % PageSize)));
+        if (Translate(vaddr, &paddr, 0) != NoException)
+            return -1;
+        src = &(kernel->machine->mainMemory[paddr]);
+        end = (char *) memchr(src, '\0', span);
+        if (end != NULL) {
+            bcopy(src, into + len, end - src);
+            len += end - src;
+            into[len] = '\0';
+            return len;
+        }
+        bcopy(src, into + len, span);
+        len += span;
+        vaddr += span;
+    }
+    return -1;				// string too long
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::PhysicalRange
+//  If the "size" bytes at user virtual address "vaddr" occupy
+//  consecutive physical frames, return a pointer to them in
+//  mainMemory, so the kernel can transfer data in place without a
+//  staging buffer.  "mode" is as for Translate.
+//
+//  Return NULL if some page could not be translated, or the frames
+//  are not contiguous; the caller should then use CopyToUser or
+//  CopyFromUser.
+//----------------------------------------------------------------------
+
+char *
+AddrSpace::PhysicalRange(unsigned int vaddr, int size, int mode)
+{
+    unsigned int first, paddr, page;
+
+    if (size <= 0 || Translate(vaddr, &first, mode) != NoException)
+        return NULL;
+    for (page = vaddr / PageSize + 1;
+         page <= (vaddr + size - 1) / PageSize; page++) {
+        if (Translate(page * PageSize, &paddr, mode) != NoException)
+            return NULL;
+        if (paddr != first + (page * PageSize - vaddr))
+            return NULL;
+    }
+    return &(kernel->machine->mainMemory[first]);
+}
@@ -17,6 +17,8 @@
 #include "filesys.h"
 
 #define UserStackSize		1024 	// increase this as necessary!
+#define MaxUserStringLen	256	// longest string (e.g., a file name)
+					// a system call copies in
 
 class AddrSpace {
   public:
@@ -39,6 +41,25 @@ class AddrSpace {
     // is 0 for Read, 1 for Write.
     ExceptionType Translate(unsigned int vaddr, unsigned int *paddr, int mode);
 
+    unsigned int Size() { return numPages * PageSize; }
+					// bytes of user virtual memory; no
+					// user buffer can be bigger
+
+    // Move data between user virtual memory and a kernel buffer.
+    // These translate once per page, and copy each page-sized span
+    // in one go.  They return FALSE (or -1) if part of the user
+    // range has no valid translation.
+    bool CopyFromUser(char *into, unsigned int vaddr, int size);
+    bool CopyToUser(unsigned int vaddr, char *from, int size);
+    int CopyStringFromUser(char *into, unsigned int vaddr, int maxLen);
+					// copy a null-terminated string of
+					// at most maxLen bytes (including
+					// the '\0'); return its length
+
+    char *PhysicalRange(unsigned int vaddr, int size, int mode);
+					// host pointer to a user range that is
+					// contiguous in mainMemory, else NULL
+
   private:
     TranslationEntry *pageTable;	// Assume linear page table translation
 					// for now!
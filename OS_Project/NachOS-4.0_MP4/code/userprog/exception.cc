@@ -54,6 +54,9 @@ ExceptionHandler(ExceptionType which)
     int type = kernel->machine->ReadRegister(2);
 	int val;
     int status, exit, threadID, programID;
+    int size;
+    AddrSpace *space = kernel->currentThread->space;
+    char *frames;
 	DEBUG(dbgSys, "Received Exception " << which << " type: " << type << "\n");
     switch (which) {
     case SyscallException:
@@ -68,8 +71,9 @@ ExceptionHandler(ExceptionType which)
 			DEBUG(dbgSys, "Message received.\n");
 			val = kernel->machine->ReadRegister(4);
 			{
-			char *msg = &(kernel->machine->mainMemory[val]);
-			cout << msg << endl;
+			char msg[MaxUserStringLen];
+			if (space->CopyStringFromUser(msg, val, MaxUserStringLen) >= 0)
+				cout << msg << endl;
 			}
 			SysHalt();
 			ASSERTNOTREACHED();
@@ -78,9 +82,11 @@ ExceptionHandler(ExceptionType which)
 		case SC_Create:
 			val = kernel->machine->ReadRegister(4);
 			{
-			char *filename = &(kernel->machine->mainMemory[val]);
-			//cout << filename << endl;
-			status = SysCreate(filename);
+			char filename[MaxUserStringLen];
+			if (space->CopyStringFromUser(filename, val, MaxUserStringLen) < 0)
+				status = 0;
+			else
+				status = SysCreate(filename);
 			kernel->machine->WriteRegister(2, (int) status);
 			}
 			kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
@@ -93,9 +99,11 @@ ExceptionHandler(ExceptionType which)
 		case SC_Create:
 			val = kernel->machine->ReadRegister(4);
                         {
-                        char *filename = &(kernel->machine->mainMemory[val]);
-                        //cout << filename << endl;
-                        status = SysCreate(filename, (int)kernel->machine->ReadRegister(5));
+                        char filename[MaxUserStringLen];
+                        if (space->CopyStringFromUser(filename, val, MaxUserStringLen) < 0)
+                            status = 0;
+                        else
+                            status = SysCreate(filename, (int)kernel->machine->ReadRegister(5));
                         kernel->machine->WriteRegister(2, (int) status);
                        	}
                         kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
@@ -108,9 +116,11 @@ ExceptionHandler(ExceptionType which)
 		case SC_Open:
 			val = kernel->machine->ReadRegister(4);
                         {
-                        char *filename = &(kernel->machine->mainMemory[val]);
-                        //cout << filename << endl;
-                        status = SysOpen(filename);
+                        char filename[MaxUserStringLen];
+                        if (space->CopyStringFromUser(filename, val, MaxUserStringLen) < 0)
+                            status = -1;
+                        else
+                            status = SysOpen(filename);
                         kernel->machine->WriteRegister(2, (int) status);
                        	}
                         kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
@@ -121,12 +131,21 @@ ExceptionHandler(ExceptionType which)
 			break;
 		case SC_Read:
 			val = kernel->machine->ReadRegister(4);
-                        {
-                        char *filename = &(kernel->machine->mainMemory[val]);
-                        //cout << filename << endl;
-                        status = SysRead(filename, (int)kernel->machine->ReadRegister(5), (int)kernel->machine->ReadRegister(6));
+                        size = (int)kernel->machine->ReadRegister(5);
+                        if (size < 0 || (unsigned int) size > space->Size())
+                            status = -1;
+                        else if ((frames = space->PhysicalRange(val, size, 1)) != NULL) {
+                            // the file system reads straight into the
+                            // user's frames
+                            status = SysRead(frames, size, (int)kernel->machine->ReadRegister(6));
+                        } else {
+                            char *buffer = new char[size];
+                            status = SysRead(buffer, size, (int)kernel->machine->ReadRegister(6));
+                            if (status > 0 && !space->CopyToUser(val, buffer, status))
+                                status = -1;
+                            delete [] buffer;
+                        }
                         kernel->machine->WriteRegister(2, (int) status);
-                       	}
                         kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
                         kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
                         kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);
@@ -135,13 +154,18 @@ ExceptionHandler(ExceptionType which)
 			break;
 		case SC_Write:
 			val = kernel->machine->ReadRegister(4);
-                        {
-                        char *filename = &(kernel->machine->mainMemory[val]);
-                        //cout << filename << endl;
-                        //printf("%d\n", (int)kernel->machine->ReadRegister(6));
-			status = SysWrite(filename, (int)kernel->machine->ReadRegister(5), (int)kernel->machine->ReadRegister(6));
+                        size = (int)kernel->machine->ReadRegister(5);
+                        if (size < 0 || (unsigned int) size > space->Size())
+                            status = -1;
+                        else {
+                            char *buffer = new char[size];
+                            if (!space->CopyFromUser(buffer, val, size))
+                                status = -1;
+                            else
+                                status = SysWrite(buffer, size, (int)kernel->machine->ReadRegister(6));
+                            delete [] buffer;
+                        }
                         kernel->machine->WriteRegister(2, (int) status);
-                       	}
                         kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
                         kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
                         kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);